@@ -0,0 +1,1171 @@
+#include "bitboard.h"
+#include "valuetable.h"
+#include "slidetable.h"
+#include "util/co.h"
+
+#include <algorithm>
+#include <memory.h>
+
+using namespace std;
+
+static const int g_scoreCheckmate = board::SCORE_CHECKMATE;// 将死对方的分数
+static const int g_scoreWin       = board::SCORE_WIN;       // 分数大于此界限均为胜利
+static const int g_maxDepth       = 32;   // 迭代加深的最大深度
+static const int g_maxPly         = 64;   // 距根节点的最大步数
+static const int g_noSquare       = 90;   // 无效的马腿、象眼，board_[90]恒为空
+
+static const int g_pieceWeight[8] = {0, 100, 2, 2, 4, 9, 5, 1};// MVV/LVA使用的棋子价值，下标为PIECE_E
+
+static BitBoard::TBits g_kingMoves[90];
+static BitBoard::TBits g_advisorMoves[90];
+static BitBoard::TBits g_bishopMoves[90][16]; // 以四个象眼的占用为下标
+static uint8_t         g_bishopEyes[90][4];
+static BitBoard::TBits g_knightMoves[90][16]; // 以四个马腿的占用为下标
+static uint8_t         g_knightLegs[90][4];
+static BitBoard::TBits g_knightCheckers[90][16];// 能走到该格的马所在的格子，以该格四个斜向相邻格(即马腿)的占用为下标
+static uint8_t         g_knightCheckLegs[90][4];
+static BitBoard::TBits g_pawnMoves[2][90];
+static BitBoard::TBits g_pawnCheckers[2][90];// 该方的兵在哪些格子能走到该格
+static BitBoard::TBits g_lines[90];        // 同行、同列的其他格子
+static BitBoard::TBits g_between[90][90];  // 同行或同列的两格之间的格子
+
+static Zobrist g_zoPlayer;
+static Zobrist g_zoTable[14][90];// 红方棋子0~6，黑方棋子7~13
+
+static inline bool isOnBoard(int row, int col)
+{
+    return row >= 0 && row < 10 && col >= 0 && col < 9;
+}
+
+static inline bool isInPalace(int row, int col)
+{
+    return col >= 3 && col <= 5 && (row <= 2 || row >= 7);
+}
+
+static inline int makeSquare(int row, int col)
+{
+    return row * 9 + col;
+}
+
+static bool initTables()
+{
+    static const int orth[4][2] = {{-1, 0}, {0, -1}, {0, 1}, {1, 0}};
+    static const int diag[4][2] = {{-1, -1}, {-1, 1}, {1, -1}, {1, 1}};
+
+    for (int row = 0; row < 10; row++)
+    {
+        for (int col = 0; col < 9; col++)
+        {
+            int sq = makeSquare(row, col);
+
+            for (int i = 0; i < 4; i++)
+            {
+                // 将：九宫内的相邻格
+                int r = row + orth[i][0];
+                int c = col + orth[i][1];
+                if (isInPalace(row, col) && isOnBoard(r, c) && isInPalace(r, c))
+                {
+                    g_kingMoves[sq].flip(makeSquare(r, c));
+                }
+
+                // 士：九宫内的斜向相邻格
+                r = row + diag[i][0];
+                c = col + diag[i][1];
+                if (isInPalace(row, col) && isOnBoard(r, c) && isInPalace(r, c))
+                {
+                    g_advisorMoves[sq].flip(makeSquare(r, c));
+                }
+
+                // 象：不过河，象眼为斜向相邻格
+                g_bishopEyes[sq][i] = isOnBoard(r, c) ? makeSquare(r, c) : g_noSquare;
+                // 马：马腿为直向相邻格
+                g_knightLegs[sq][i] = isOnBoard(row + orth[i][0], col + orth[i][1]) ? makeSquare(row + orth[i][0], col + orth[i][1]) : g_noSquare;
+                // 将马：马腿为将的斜向相邻格
+                g_knightCheckLegs[sq][i] = g_bishopEyes[sq][i];
+            }
+
+            for (int occ = 0; occ < 16; occ++)
+            {
+                for (int i = 0; i < 4; i++)
+                {
+                    if (occ & (1 << i))
+                    {
+                        continue;
+                    }
+
+                    int r = row + diag[i][0] * 2;
+                    int c = col + diag[i][1] * 2;
+                    if (isOnBoard(r, c) && (r <= 4) == (row <= 4))
+                    {
+                        g_bishopMoves[sq][occ].flip(makeSquare(r, c));
+                    }
+
+                    for (int j = -1; j <= 1; j += 2)
+                    {
+                        // 马腿方向走两格，再向两侧走一格
+                        r = row + orth[i][0] * 2 + orth[i][1] * j;
+                        c = col + orth[i][1] * 2 + orth[i][0] * j;
+                        if (isOnBoard(r, c))
+                        {
+                            g_knightMoves[sq][occ].flip(makeSquare(r, c));
+                        }
+                    }
+
+                    // 斜向相邻格为马腿，马在其外侧的两个格子
+                    r = row + diag[i][0] * 2;
+                    c = col + diag[i][1];
+                    if (isOnBoard(r, c))
+                    {
+                        g_knightCheckers[sq][occ].flip(makeSquare(r, c));
+                    }
+
+                    r = row + diag[i][0];
+                    c = col + diag[i][1] * 2;
+                    if (isOnBoard(r, c))
+                    {
+                        g_knightCheckers[sq][occ].flip(makeSquare(r, c));
+                    }
+                }
+            }
+
+            // 兵：红方向上、黑方向下，过河后可左右走
+            for (int color = 0; color < 2; color++)
+            {
+                int forward = (color == 0) ? row - 1 : row + 1;
+                bool crossed = (color == 0) ? row <= 4 : row >= 5;
+
+                if (isOnBoard(forward, col))
+                {
+                    g_pawnMoves[color][sq].flip(makeSquare(forward, col));
+                }
+
+                for (int j = -1; crossed && j <= 1; j += 2)
+                {
+                    if (isOnBoard(row, col + j))
+                    {
+                        g_pawnMoves[color][sq].flip(makeSquare(row, col + j));
+                    }
+                }
+            }
+
+            // 同行、同列
+            for (int other = 0; other < 90; other++)
+            {
+                int r = other / 9;
+                int c = other % 9;
+
+                if (other == sq || (r != row && c != col))
+                {
+                    continue;
+                }
+
+                g_lines[sq].flip(other);
+
+                for (int mid = std::min(sq, other) + 1; mid < std::max(sq, other); mid++)
+                {
+                    if ((r == row && mid / 9 == row) || (c == col && mid % 9 == col))
+                    {
+                        g_between[sq][other].flip(mid);
+                    }
+                }
+            }
+        }
+    }
+
+    // 兵的将军表是走法表的逆
+    for (int color = 0; color < 2; color++)
+    {
+        for (int sq = 0; sq < 90; sq++)
+        {
+            BitBoard::TBits moves = g_pawnMoves[color][sq];
+            while (moves.any())
+            {
+                g_pawnCheckers[color][moves.popFirst()].flip(sq);
+            }
+        }
+    }
+
+    // 用同一个密码流依次填充所有键值
+    RC4 rc4;
+
+    g_zoPlayer = Zobrist(rc4);
+    for (int i = 0; i < 14; i++)
+    {
+        for (int j = 0; j < 90; j++)
+        {
+            g_zoTable[i][j] = Zobrist(rc4);
+        }
+    }
+
+    return true;
+}
+
+static const bool g_tablesInited = initTables();
+
+// 四个马腿(象眼)的占用
+static inline int getLegIndex(const uint8_t* board, const uint8_t* legs)
+{
+    return (board[legs[0]] != 0) | ((board[legs[1]] != 0) << 1) | ((board[legs[2]] != 0) << 2) | ((board[legs[3]] != 0) << 3);
+}
+
+BitBoard::BitBoard()
+    : redScore_(0)
+    , blackScore_(0)
+    , player_(def::PLAYER_red)
+    , distance_(0)
+    , tt_(std::make_shared<TransTable>())
+    , stop_(std::make_shared<std::atomic<bool>>(false))
+    , ponder_(std::make_shared<std::atomic<bool>>(false))
+    , timeout_(false)
+    , nodes_(0)
+    , depth_(0)
+    , ponderMove_(0)
+{
+    memset(board_, 0, sizeof(board_));
+    memset(pieces_, 0, sizeof(pieces_));
+    memset(&occupied_, 0, sizeof(occupied_));
+    memset(rankOcc_, 0, sizeof(rankOcc_));
+    memset(fileOcc_, 0, sizeof(fileOcc_));
+    memset(kings_, 0, sizeof(kings_));
+    memset(killers_, 0, sizeof(killers_));
+    memset(history_, 0, sizeof(history_));
+}
+
+// 开局
+void BitBoard::init()
+{
+    static const uint8_t initBoard[90] = {
+        21, 20, 19, 18, 17, 18, 19, 20, 21,
+         0,  0,  0,  0,  0,  0,  0,  0,  0,
+         0, 22,  0,  0,  0,  0,  0, 22,  0,
+        23,  0, 23,  0, 23,  0, 23,  0, 23,
+         0,  0,  0,  0,  0,  0,  0,  0,  0,
+         0,  0,  0,  0,  0,  0,  0,  0,  0,
+        15,  0, 15,  0, 15,  0, 15,  0, 15,
+         0, 14,  0,  0,  0,  0,  0, 14,  0,
+         0,  0,  0,  0,  0,  0,  0,  0,  0,
+        13, 12, 11, 10,  9, 10, 11, 12, 13
+    };
+
+    // 清空棋盘后逐个添加棋子，同时计算位集合、分数及Zobrist键值
+    memset(board_, 0, sizeof(board_));
+    memset(pieces_, 0, sizeof(pieces_));
+    memset(&occupied_, 0, sizeof(occupied_));
+    memset(rankOcc_, 0, sizeof(rankOcc_));
+    memset(fileOcc_, 0, sizeof(fileOcc_));
+    redScore_ = 0;
+    blackScore_ = 0;
+    zoCurr_.clear();
+
+    for (int sq = 0; sq < 90; sq++)
+    {
+        if (initBoard[sq] != 0)
+        {
+            addPiece(sq, static_cast<def::ICON_E>(initBoard[sq]));
+        }
+    }
+
+    player_ = def::PLAYER_red;
+    distance_ = 0;
+    records_.clear();
+    memset(killers_, 0, sizeof(killers_));
+    memset(history_, 0, sizeof(history_));
+    tt_->clear();
+}
+
+// 电脑计算走棋
+uint8_t BitBoard::autoMove()
+{
+    def::TMove move = def::INVALID_MOVE;
+
+    if (!searchMove(move))
+    {
+        return 0;
+    }
+
+    return makeMove(move);
+}
+
+uint8_t BitBoard::makeMove(def::TMove move)
+{
+    if (!co::isValidPos(move.src) || !co::isValidPos(move.dst))
+    {
+        return board::MOVE_RET_invalid;
+    }
+
+    uint16_t innerMove = static_cast<uint16_t>(toSquare(move.src) | (toSquare(move.dst) << 8));
+
+    if (!isValidMove(innerMove))
+    {
+        return board::MOVE_RET_invalid;
+    }
+
+    if (!doMove(innerMove)) // 走棋导致自己被将军，即为自杀
+    {
+        return board::MOVE_RET_suicide;
+    }
+
+    uint8_t ret = board::MOVE_RET_ok;
+
+    if (records_.top().capture != 0)
+    {
+        ret |= board::MOVE_RET_eat;
+    }
+
+    if (givesCheck()) // 缓存到历史记录中，搜索时判断长将需要用到
+    {
+        ret |= board::MOVE_RET_check;
+    }
+
+    if (!hasLegalMove()) // 被将死或困毙都判负，与SlimBoard一致
+    {
+        ret |= board::MOVE_RET_dead;
+    }
+
+    return ret;
+}
+
+// 悔棋
+bool BitBoard::undoMakeMove()
+{
+    if (records_.empty())
+    {
+        return false;
+    }
+
+    undoMove();
+
+    return true;
+}
+
+// 复制当前局面，副本与原棋盘共享置换表，但使用独立的中止标志
+shared_ptr<board::IBoard> BitBoard::clone() const
+{
+    shared_ptr<BitBoard> board = std::make_shared<BitBoard>(*this);
+    board->stop_ = std::make_shared<std::atomic<bool>>(false);
+    board->ponder_ = std::make_shared<std::atomic<bool>>(false);
+    board->infoCallback_ = nullptr;
+    return board;
+}
+
+// 搜索最佳走法但不走棋，搜索时间由timeManager_的限制决定
+bool BitBoard::searchMove(def::TMove& move)
+{
+    uint16_t innerMove = fullSearch();
+    ponderMove_ = 0;
+
+    if (innerMove == 0) // 被中止或无棋可走
+    {
+        return false;
+    }
+
+    vector<uint16_t> pv;
+    getPV(innerMove, pv);
+    if (pv.size() > 1)
+    {
+        ponderMove_ = pv[1];
+    }
+
+    move = toMove(innerMove);
+    return true;
+}
+
+void BitBoard::stopSearch()
+{
+    stop_->store(true);
+}
+
+void BitBoard::setPonder(bool on)
+{
+    ponder_->store(on);
+}
+
+def::TMove BitBoard::getPonderMove() const
+{
+    return ponderMove_ != 0 ? toMove(ponderMove_) : def::INVALID_MOVE;
+}
+
+void BitBoard::setInfoCallback(const board::InfoCallback& callback)
+{
+    infoCallback_ = callback;
+}
+
+int BitBoard::getScore(def::PLAYER_E player) const
+{
+    if (player == def::PLAYER_black)
+    {
+        return blackScore_;
+    }
+    else if (player == def::PLAYER_red)
+    {
+        return redScore_;
+    }
+    else
+    {
+        return 0;
+    }
+}
+
+def::ICON_E BitBoard::getIcon(def::TPos pos) const
+{
+    return co::isValidPos(pos) ? static_cast<def::ICON_E>(board_[toSquare(pos)]) : def::ICON_empty;
+}
+
+def::PLAYER_E BitBoard::getOwner(def::TPos pos) const
+{
+    return def::extractOwner(getIcon(pos));
+}
+
+def::PLAYER_E BitBoard::getNextPlayer() const
+{
+    return player_;
+}
+
+def::TMove BitBoard::getTrigger() const
+{
+    return records_.empty() ? def::INVALID_MOVE : toMove(records_.top().move);
+}
+
+void BitBoard::setSearchLimits(const TimeManager::TLimits& limits)
+{
+    timeManager_.setLimits(limits);
+}
+
+const TimeManager::TLimits& BitBoard::getSearchLimits() const
+{
+    return timeManager_.getLimits();
+}
+
+uint64_t BitBoard::perft(int depth)
+{
+    if (depth == 0)
+    {
+        return 1;
+    }
+
+    MoveList moves;
+    generateMoves(moves);
+
+    uint64_t count = 0;
+    for (uint16_t move: moves)
+    {
+        if (doMove(move))
+        {
+            count += perft(depth - 1);
+            undoMove();
+        }
+    }
+
+    return count;
+}
+
+// 添加棋子，同时更新位集合、行列占用、分数及Zobrist键值
+void BitBoard::addPiece(int sq, def::ICON_E icon)
+{
+    int color = getColor(def::extractOwner(icon));
+    int piece = def::extractPiece(icon);
+    int row = sq / 9;
+    int col = sq % 9;
+
+    board_[sq] = icon;
+    pieces_[color][piece].flip(sq);
+    pieces_[color][0].flip(sq);
+    occupied_.flip(sq);
+    rankOcc_[row] ^= 1 << col;
+    fileOcc_[col] ^= 1 << row;
+    zoCurr_.Xor(g_zoTable[color * 7 + piece - 1][sq]);
+
+    // 子力价值表使用16x16的坐标，黑方翻转
+    int idx = ((row + 3) << 4) + col + 3;
+    if (color == 0)
+    {
+        redScore_ += board::g_redValue[piece - 1][idx];
+    }
+    else
+    {
+        blackScore_ += board::g_redValue[piece - 1][254 - idx];
+    }
+
+    if (piece == def::PIECE_king)
+    {
+        kings_[color] = static_cast<uint8_t>(sq);
+    }
+}
+
+void BitBoard::delPiece(int sq, def::ICON_E icon)
+{
+    int color = getColor(def::extractOwner(icon));
+    int piece = def::extractPiece(icon);
+    int row = sq / 9;
+    int col = sq % 9;
+
+    board_[sq] = def::ICON_empty;
+    pieces_[color][piece].flip(sq);
+    pieces_[color][0].flip(sq);
+    occupied_.flip(sq);
+    rankOcc_[row] ^= 1 << col;
+    fileOcc_[col] ^= 1 << row;
+    zoCurr_.Xor(g_zoTable[color * 7 + piece - 1][sq]);
+
+    int idx = ((row + 3) << 4) + col + 3;
+    if (color == 0)
+    {
+        redScore_ -= board::g_redValue[piece - 1][idx];
+    }
+    else
+    {
+        blackScore_ -= board::g_redValue[piece - 1][254 - idx];
+    }
+}
+
+uint8_t BitBoard::movePiece(uint16_t move)
+{
+    int src = move & 0xff;
+    int dst = move >> 8;
+    def::ICON_E srcIcon = static_cast<def::ICON_E>(board_[src]);
+    def::ICON_E dstIcon = static_cast<def::ICON_E>(board_[dst]);
+
+    if (dstIcon != def::ICON_empty)
+    {
+        delPiece(dst, dstIcon);
+    }
+    delPiece(src, srcIcon);
+    addPiece(dst, srcIcon);
+
+    return dstIcon;
+}
+
+void BitBoard::undoMovePiece(uint16_t move, uint8_t capture)
+{
+    int src = move & 0xff;
+    int dst = move >> 8;
+    def::ICON_E icon = static_cast<def::ICON_E>(board_[dst]);
+
+    delPiece(dst, icon);
+    addPiece(src, icon);
+    if (capture != 0)
+    {
+        addPiece(dst, static_cast<def::ICON_E>(capture));
+    }
+}
+
+bool BitBoard::doMove(uint16_t move)
+{
+    uint64_t key = zoCurr_.getKey();
+    uint8_t capture = movePiece(move);
+    int color = getColor(player_);
+
+    if (isAttacked(kings_[color], color ^ 1)) // 走棋是否导致自己被将军
+    {
+        undoMovePiece(move, capture);
+        return false;
+    }
+
+    def::switchPlayer(player_);
+    zoCurr_.Xor(g_zoPlayer);
+    records_.push({move, capture, board::CHECK_unknown, key});
+    distance_++;
+
+    return true;
+}
+
+void BitBoard::undoMove()
+{
+    const TRecord& record = records_.top();
+    undoMovePiece(record.move, record.capture);
+    records_.pop();
+
+    def::switchPlayer(player_);
+    zoCurr_.Xor(g_zoPlayer);
+    distance_--;
+}
+
+// 上一步走法是否将军，即当前玩家是否被将军，第一次查询时才计算并缓存到历史记录中
+bool BitBoard::givesCheck()
+{
+    if (records_.empty())
+    {
+        return isCheck();
+    }
+
+    TRecord& record = records_.top();
+    if (record.check == board::CHECK_unknown)
+    {
+        record.check = isCheck() ? board::CHECK_yes : board::CHECK_no;
+    }
+
+    return record.check == board::CHECK_yes;
+}
+
+// 将、士、象、马、兵查表得到目标格的位集合，车、炮查行列表
+void BitBoard::generateMoves(MoveList& moves, bool captureOnly/* = false*/) const
+{
+    moves.clear();
+
+    int color = getColor(player_);
+    const TBits* own = pieces_[color];
+    TBits targets = captureOnly ? pieces_[color ^ 1][0] : ~own[0];
+    TBits bits;
+
+    pushTargets(moves, kings_[color], g_kingMoves[kings_[color]] & targets);
+
+    bits = own[def::PIECE_advisor];
+    while (bits.any())
+    {
+        int sq = bits.popFirst();
+        pushTargets(moves, sq, g_advisorMoves[sq] & targets);
+    }
+
+    bits = own[def::PIECE_bishop];
+    while (bits.any())
+    {
+        int sq = bits.popFirst();
+        pushTargets(moves, sq, g_bishopMoves[sq][getLegIndex(board_, g_bishopEyes[sq])] & targets);
+    }
+
+    bits = own[def::PIECE_knight];
+    while (bits.any())
+    {
+        int sq = bits.popFirst();
+        pushTargets(moves, sq, g_knightMoves[sq][getLegIndex(board_, g_knightLegs[sq])] & targets);
+    }
+
+    bits = own[def::PIECE_rook];
+    while (bits.any())
+    {
+        generateSlides(moves, bits.popFirst(), false, captureOnly);
+    }
+
+    bits = own[def::PIECE_cannon];
+    while (bits.any())
+    {
+        generateSlides(moves, bits.popFirst(), true, captureOnly);
+    }
+
+    bits = own[def::PIECE_pawn];
+    while (bits.any())
+    {
+        int sq = bits.popFirst();
+        pushTargets(moves, sq, g_pawnMoves[color][sq] & targets);
+    }
+}
+
+void BitBoard::generateSlides(MoveList& moves, int src, bool cannon, bool captureOnly) const
+{
+    int row = src / 9;
+    int col = src % 9;
+    const board::TSlide& rank = board::g_rankSlides[col][rankOcc_[row]];
+    const board::TSlide& file = board::g_fileSlides[row][fileOcc_[col]];
+
+    // 吃子：目标格上是对方的棋子
+    uint16_t bits = cannon ? rank.cannonCapture : rank.rookCapture;
+    while (bits != 0)
+    {
+        int dst = makeSquare(row, board::getFirstBit(bits));
+        bits &= bits - 1;
+        if ((board_[dst] & def::PLAYER_MASK) != player_)
+        {
+            moves.push(static_cast<uint16_t>(src | (dst << 8)));
+        }
+    }
+
+    bits = cannon ? file.cannonCapture : file.rookCapture;
+    while (bits != 0)
+    {
+        int dst = makeSquare(board::getFirstBit(bits), col);
+        bits &= bits - 1;
+        if ((board_[dst] & def::PLAYER_MASK) != player_)
+        {
+            moves.push(static_cast<uint16_t>(src | (dst << 8)));
+        }
+    }
+
+    if (captureOnly)
+    {
+        return;
+    }
+
+    for (bits = rank.quiet; bits != 0; bits &= bits - 1)
+    {
+        moves.push(static_cast<uint16_t>(src | (makeSquare(row, board::getFirstBit(bits)) << 8)));
+    }
+
+    for (bits = file.quiet; bits != 0; bits &= bits - 1)
+    {
+        moves.push(static_cast<uint16_t>(src | (makeSquare(board::getFirstBit(bits), col) << 8)));
+    }
+}
+
+void BitBoard::pushTargets(MoveList& moves, int src, TBits targets) const
+{
+    while (targets.any())
+    {
+        moves.push(static_cast<uint16_t>(src | (targets.popFirst() << 8)));
+    }
+}
+
+// color方是否攻击sq上的将：兵、马查表，车、炮及对面的将数两者之间的棋子
+bool BitBoard::isAttacked(int sq, int color) const
+{
+    const TBits* enemy = pieces_[color];
+
+    if ((g_pawnCheckers[color][sq] & enemy[def::PIECE_pawn]).any())
+    {
+        return true;
+    }
+
+    if ((g_knightCheckers[sq][getLegIndex(board_, g_knightCheckLegs[sq])] & enemy[def::PIECE_knight]).any())
+    {
+        return true;
+    }
+
+    TBits sliders = g_lines[sq] & (enemy[def::PIECE_rook] | enemy[def::PIECE_cannon] | enemy[def::PIECE_king]);
+    while (sliders.any())
+    {
+        int src = sliders.popFirst();
+        int count = (g_between[sq][src] & occupied_).count();
+        int piece = def::extractPiece(static_cast<def::ICON_E>(board_[src]));
+
+        if ((count == 0 && piece != def::PIECE_cannon) || (count == 1 && piece == def::PIECE_cannon))
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+bool BitBoard::isCheck() const
+{
+    int color = getColor(player_);
+    return isAttacked(kings_[color], color ^ 1);
+}
+
+bool BitBoard::hasLegalMove()
+{
+    MoveList moves;
+    generateMoves(moves);
+
+    for (uint16_t move: moves)
+    {
+        if (doMove(move))
+        {
+            undoMove();
+            return true;
+        }
+    }
+
+    return false;
+}
+
+bool BitBoard::isValidMove(uint16_t move) const
+{
+    MoveList moves;
+    generateMoves(moves);
+
+    return moves.contains(move);
+}
+
+// 迭代加深：每完成一层检查软限制，搜索中途按节点数检查硬限制
+uint16_t BitBoard::fullSearch()
+{
+    // 杀手走法与层数相关，需要清空；历史分值在相邻的搜索之间仍然有效，减半即可
+    memset(killers_, 0, sizeof(killers_));
+    for (int i = 0; i < 90; i++)
+    {
+        for (int j = 0; j < 90; j++)
+        {
+            history_[i][j] /= 2;
+        }
+    }
+    tt_->newSearch();
+    nodes_ = 0;
+    depth_ = 0;
+    timeManager_.start();
+    timeout_ = false;
+
+    // 搜索期间distance_表示相对于根节点的步数
+    int distance = distance_;
+    distance_ = 0;
+
+    uint16_t move = 0;
+
+    for (int i = 1; i <= g_maxDepth; i++)
+    {
+        uint16_t currMove = 0;
+        int score = alphabeta(i, -g_scoreCheckmate, g_scoreCheckmate, &currMove);
+
+        if (isStopped() || currMove == 0) // 被中止的这一层结果不完整
+        {
+            break;
+        }
+
+        move = currMove;
+        depth_ = i;
+
+        if (infoCallback_)
+        {
+            vector<uint16_t> pv;
+            getPV(move, pv);
+
+            board::TSearchInfo info;
+            info.depth = i;
+            info.score = score;
+            info.nodes = nodes_;
+            info.seconds = timeManager_.elapsed() / 1000.0;
+            info.nps = info.seconds > 0 ? static_cast<uint64_t>(nodes_ / info.seconds) : 0;
+            for (uint16_t pvMove: pv)
+            {
+                info.pv.push_back(toMove(pvMove));
+            }
+            infoCallback_(info);
+        }
+
+        if (score > g_scoreWin || score < -g_scoreWin) // 将死对方或被对方将死
+        {
+            break;
+        }
+
+        timeManager_.onIteration(move, score);
+        if (!ponder_->load() && timeManager_.shouldStop(i, nodes_))
+        {
+            break;
+        }
+    }
+
+    distance_ = distance;
+
+    // 被外部中止时结果不再使用
+    bool cancelled = stop_->load();
+    stop_->store(false);
+    timeout_ = false;
+
+    return cancelled ? 0 : move;
+}
+
+// 主要变例搜索，被将军时延伸一层
+int BitBoard::alphabeta(int depth, int alpha, int beta, uint16_t* pNextMove)
+{
+    if (depth <= 0 && pNextMove == nullptr)
+    {
+        return quiescentSearch(alpha, beta);
+    }
+
+    nodes_++;
+    pollLimits();
+
+    if (isStopped())
+    {
+        return 0;
+    }
+
+    // 是否被将军需要在检查重复局面之前确定，长将判断需要用到
+    bool inCheck = givesCheck();
+
+    if (pNextMove == nullptr)
+    {
+        // 重复局面按与SlimBoard相同的规则判定：单方面长将判负，否则判和
+        if (int status = board::detectRepeat(records_, zoCurr_.getKey(), 1))
+        {
+            return board::getRepeatScore(status, distance_);
+        }
+
+        if (distance_ >= g_maxPly - 1)
+        {
+            return evaluate();
+        }
+
+        // 杀棋步数裁剪
+        alpha = std::max(alpha, -g_scoreCheckmate + distance_);
+        beta = std::min(beta, g_scoreCheckmate - distance_ - 1);
+        if (alpha >= beta)
+        {
+            return alpha;
+        }
+    }
+
+    uint64_t key = zoCurr_.getKey();
+    uint16_t hashMove = 0;
+    TransTable::TEntry entry;
+
+    if (tt_->probe(key, entry))
+    {
+        hashMove = entry.move;
+
+        if (pNextMove == nullptr && entry.depth >= depth)
+        {
+            int score = board::scoreFromTT(entry.score, distance_);
+            TransTable::BOUND_E bound = entry.getBound();
+
+            if ((bound == TransTable::BOUND_exact) ||
+                (bound == TransTable::BOUND_lower && score >= beta) ||
+                (bound == TransTable::BOUND_upper && score <= alpha))
+            {
+                return score;
+            }
+        }
+    }
+
+    if (inCheck)
+    {
+        depth++;
+    }
+
+    MoveList moves;
+    generateMoves(moves);
+    scoreMoves(moves, hashMove);
+
+    int oldAlpha = alpha;
+    int maxScore = -g_scoreCheckmate;
+    uint16_t maxMove = 0;
+    int legal = 0;
+    uint16_t quiets[64];// 已搜索的不吃子走法，截断时降低它们的历史分值
+    int quietCount = 0;
+
+    for (int i = 0; i < moves.size(); i++)
+    {
+        moves.pickBest(i);
+        uint16_t move = moves.getMove(i);
+        bool capture = board_[move >> 8] != 0;
+
+        if (!doMove(move))
+        {
+            continue;
+        }
+
+        int val;
+        if (legal == 0)
+        {
+            val = -alphabeta(depth - 1, -beta, -alpha, nullptr);
+        }
+        else
+        {
+            val = -alphabeta(depth - 1, -alpha - 1, -alpha, nullptr);
+            if (val > alpha && val < beta)
+            {
+                val = -alphabeta(depth - 1, -beta, -alpha, nullptr);
+            }
+        }
+
+        undoMove();
+        legal++;
+
+        if (isStopped())
+        {
+            return 0;
+        }
+
+        if (!capture && quietCount < 64)
+        {
+            quiets[quietCount++] = move;
+        }
+
+        if (val > maxScore)
+        {
+            maxScore = val;
+            maxMove = move;
+            alpha = std::max(alpha, val);
+        }
+
+        if (alpha >= beta) // beta截断，不吃子走法记入杀手走法及历史表
+        {
+            if (!capture)
+            {
+                if (killers_[distance_][0] != move)
+                {
+                    killers_[distance_][1] = killers_[distance_][0];
+                    killers_[distance_][0] = move;
+                }
+
+                // 截断走法提高历史分值，之前搜索过但没有截断的不吃子走法降低
+                int bonus = std::min(depth * depth, board::HISTORY_BONUS_MAX);
+                board::updateHistory(history_[move & 0xff][move >> 8], bonus);
+                for (int j = 0; j < quietCount - 1; j++)
+                {
+                    board::updateHistory(history_[quiets[j] & 0xff][quiets[j] >> 8], -bonus);
+                }
+            }
+
+            break;
+        }
+    }
+
+    if (legal == 0) // 无棋可走即被将死
+    {
+        return -g_scoreCheckmate + distance_;
+    }
+
+    TransTable::BOUND_E bound = (maxScore >= beta) ? TransTable::BOUND_lower :
+                                (maxScore > oldAlpha) ? TransTable::BOUND_exact : TransTable::BOUND_upper;
+    tt_->store(key, maxMove, board::scoreToTT(maxScore, distance_), depth, bound);
+
+    if (pNextMove != nullptr)
+    {
+        *pNextMove = maxMove;
+    }
+
+    return maxScore;
+}
+
+// 静态搜索：只搜索吃子走法，被将军时搜索所有走法
+int BitBoard::quiescentSearch(int alpha, int beta)
+{
+    nodes_++;
+    pollLimits();
+
+    if (isStopped())
+    {
+        return 0;
+    }
+
+    if (distance_ >= g_maxPly - 1)
+    {
+        return evaluate();
+    }
+
+    bool inCheck = givesCheck();
+    if (int status = board::detectRepeat(records_, zoCurr_.getKey(), 1))
+    {
+        return board::getRepeatScore(status, distance_);
+    }
+
+    int maxScore = -g_scoreCheckmate + distance_;
+
+    if (!inCheck)
+    {
+        int standPat = evaluate();
+        if (standPat >= beta)
+        {
+            return standPat;
+        }
+
+        maxScore = standPat;
+        alpha = std::max(alpha, standPat);
+    }
+
+    MoveList moves;
+    generateMoves(moves, !inCheck);
+    scoreMoves(moves, 0);
+
+    for (int i = 0; i < moves.size(); i++)
+    {
+        moves.pickBest(i);
+        uint16_t move = moves.getMove(i);
+
+        if (!doMove(move))
+        {
+            continue;
+        }
+
+        int val = -quiescentSearch(-beta, -alpha);
+        undoMove();
+
+        if (isStopped())
+        {
+            return 0;
+        }
+
+        if (val > maxScore)
+        {
+            maxScore = val;
+            if (val > alpha)
+            {
+                alpha = val;
+                if (alpha >= beta)
+                {
+                    break;
+                }
+            }
+        }
+    }
+
+    return maxScore;
+}
+
+// 走法排序：置换表走法、MVV/LVA排序的吃子走法、杀手走法、历史分值
+void BitBoard::scoreMoves(MoveList& moves, uint16_t hashMove) const
+{
+    const uint16_t* killers = killers_[std::min(distance_, g_maxPly - 1)];
+
+    for (int i = 0; i < moves.size(); i++)
+    {
+        uint16_t move = moves.getMove(i);
+        int src = move & 0xff;
+        int dst = move >> 8;
+        int score;
+
+        if (move == hashMove)
+        {
+            score = 1 << 30;
+        }
+        else if (board_[dst] != 0)
+        {
+            score = (1 << 29) + g_pieceWeight[def::extractPiece(static_cast<def::ICON_E>(board_[dst]))] * 128 -
+                    g_pieceWeight[def::extractPiece(static_cast<def::ICON_E>(board_[src]))];
+        }
+        else if (move == killers[0])
+        {
+            score = (1 << 28) + 1;
+        }
+        else if (move == killers[1])
+        {
+            score = 1 << 28;
+        }
+        else
+        {
+            score = history_[src][dst];
+        }
+
+        moves.setScore(i, score);
+    }
+}
+
+// 从置换表中依次取出最佳走法得到主要变例，遇到重复局面或非法走法即停止
+void BitBoard::getPV(uint16_t move, vector<uint16_t>& pv)
+{
+    board::getPV(*this, *tt_, move, g_maxPly, pv);
+}
+
+int BitBoard::evaluate() const
+{
+    return (player_ == def::PLAYER_red) ? (redScore_ - blackScore_) : (blackScore_ - redScore_);
+}
+
+bool BitBoard::isStopped() const
+{
+    return timeout_ || stop_->load(std::memory_order_relaxed);
+}
+
+// 规则见TimeManager::pollHardLimit
+void BitBoard::pollLimits()
+{
+    if (timeManager_.pollHardLimit(nodes_, depth_, *ponder_))
+    {
+        timeout_ = true;
+    }
+}
+
+uint64_t BitBoard::getKey() const
+{
+    return zoCurr_.getKey();
+}
+
+int BitBoard::toSquare(def::TPos pos)
+{
+    return pos.row * 9 + pos.col;
+}
+
+def::TPos BitBoard::toPos(int sq)
+{
+    return {static_cast<int8_t>(sq / 9), static_cast<int8_t>(sq % 9)};
+}
+
+def::TMove BitBoard::toMove(uint16_t move)
+{
+    return {toPos(move & 0xff), toPos(move >> 8)};
+}
+
+int BitBoard::getColor(def::PLAYER_E player)
+{
+    return player >> 4; // 红方0x08，黑方0x10
+}
@@ -0,0 +1,206 @@
+#ifndef BITBOARD_H
+#define BITBOARD_H
+
+#include "board/board.h"
+#include "board/movelist.h"
+#include "board/transtable.h"
+#include "board/timemanager.h"
+#include "board/searchutil.h"
+#include "util/zobrist.h"
+#include "util/mystack.h"
+
+#include <vector>
+#include <memory>
+#include <atomic>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+using std::vector;
+using std::shared_ptr;
+
+// 位棋盘：第row * 9 + col格表示(row, col)，走法的低8位为起点格、高8位为终点格
+// 各方各类棋子各用一个90位的位集合，将、士、象、马、兵的走法及将军判断查预先计算的表，
+// 车、炮查以行、列占用位为下标的表，车、炮、将的将军判断用两格之间的位集合与占用位相与后计数
+class BitBoard : public board::IBoard
+{
+public:
+    // 90个格子的位集合，低64位保存第0~63格，高26位保存第64~89格
+    struct TBits
+    {
+        uint64_t lo;
+        uint64_t hi;
+
+        static const uint64_t HI_MASK = (1ULL << 26) - 1;
+
+        bool test(int sq) const
+        {
+            return sq < 64 ? ((lo >> sq) & 1) != 0 : ((hi >> (sq - 64)) & 1) != 0;
+        }
+
+        void flip(int sq)
+        {
+            if (sq < 64)
+            {
+                lo ^= 1ULL << sq;
+            }
+            else
+            {
+                hi ^= 1ULL << (sq - 64);
+            }
+        }
+
+        bool any() const
+        {
+            return (lo | hi) != 0;
+        }
+
+        int count() const
+        {
+            return popCount(lo) + popCount(hi);
+        }
+
+        // 取出最低位的格子，集合不能为空
+        int popFirst()
+        {
+            if (lo != 0)
+            {
+                int sq = firstBit(lo);
+                lo &= lo - 1;
+                return sq;
+            }
+
+            int sq = firstBit(hi) + 64;
+            hi &= hi - 1;
+            return sq;
+        }
+
+        TBits operator&(const TBits& rhs) const { return {lo & rhs.lo, hi & rhs.hi}; }
+        TBits operator|(const TBits& rhs) const { return {lo | rhs.lo, hi | rhs.hi}; }
+        TBits operator~() const { return {~lo, ~hi & HI_MASK}; }
+        TBits& operator|=(const TBits& rhs) { lo |= rhs.lo; hi |= rhs.hi; return *this; }
+
+        static int popCount(uint64_t x)
+        {
+#if defined(_MSC_VER)
+            return static_cast<int>(__popcnt64(x));
+#else
+            return __builtin_popcountll(x);
+#endif
+        }
+
+        static int firstBit(uint64_t x)
+        {
+#if defined(_MSC_VER)
+            unsigned long idx;
+            _BitScanForward64(&idx, x);
+            return static_cast<int>(idx);
+#else
+            return __builtin_ctzll(x);
+#endif
+        }
+    };
+
+public:
+    BitBoard();
+
+    virtual void init();                                    // 开局
+    virtual uint8_t autoMove();                             // 电脑走棋,返回EMoveRet的组合
+    virtual uint8_t makeMove(def::TMove move);              // 指定走法走棋,返回EMoveRet的组合
+    virtual bool undoMakeMove();                            // 悔棋
+
+    virtual shared_ptr<board::IBoard> clone() const;        // 复制当前局面，供后台线程搜索
+    virtual bool searchMove(def::TMove& move);              // 搜索最佳走法但不走棋，被中止则返回false
+    virtual void stopSearch();                              // 中止正在进行的搜索，可在其他线程调用
+    virtual void setPonder(bool on);                        // 后台思考模式下不受时间限制，解除后计入已用时间
+    virtual def::TMove getPonderMove() const;               // 置换表中最佳走法之后的对方应着
+    virtual void setInfoCallback(const board::InfoCallback& callback);// 每完成一层迭代回调一次
+
+    virtual int getScore(def::PLAYER_E player) const;       // 获取当前局面下的玩家分数
+    virtual def::ICON_E getIcon(def::TPos pos) const;       // 获取某一位置的棋子
+    virtual def::PLAYER_E getOwner(def::TPos pos) const;    // 获取pos棋子所属玩家
+    virtual def::PLAYER_E getNextPlayer() const;            // 获取下一走棋玩家
+    virtual def::TMove getTrigger() const;                  // 表示该snapshot是由trigger的两个位置移动产生的，用于绘制select图标
+
+public:
+    void setSearchLimits(const TimeManager::TLimits& limits);// 设置搜索的时间、节点数、深度限制
+    const TimeManager::TLimits& getSearchLimits() const;
+    uint64_t perft(int depth);// 统计depth层的合法走法路径数，用于与SlimBoard对照走法生成
+
+protected:
+    void addPiece(int sq, def::ICON_E icon);
+    void delPiece(int sq, def::ICON_E icon);
+    uint8_t movePiece(uint16_t move);
+    void undoMovePiece(uint16_t move, uint8_t capture);
+    bool doMove(uint16_t move);// 搜索使用，自杀则返回false
+    void undoMove();
+    bool givesCheck();// 上一步走法是否将军，按需计算并缓存到历史记录中
+
+    void generateMoves(MoveList& moves, bool captureOnly = false) const;// 生成当前玩家的伪合法走法
+    void generateSlides(MoveList& moves, int src, bool cannon, bool captureOnly) const;// 车、炮的走法
+    inline void pushTargets(MoveList& moves, int src, TBits targets) const;
+    bool isAttacked(int sq, int color) const;// color方是否攻击sq上的将
+    bool isCheck() const;// 当前玩家是否被将军
+    bool hasLegalMove();
+    bool isValidMove(uint16_t move) const;// 是否为当前玩家的伪合法走法
+
+    // 搜索
+    uint16_t fullSearch();// 迭代加深的alpha-beta搜索
+    int alphabeta(int depth, int alpha, int beta, uint16_t* pNextMove);
+    int quiescentSearch(int alpha, int beta);
+    void scoreMoves(MoveList& moves, uint16_t hashMove) const;
+    void getPV(uint16_t move, vector<uint16_t>& pv);// 从置换表中取出以move开始的主要变例
+    inline int evaluate() const;// 相对于当前玩家的局面分
+    inline bool isStopped() const;
+    inline void pollLimits();
+
+    inline uint64_t getKey() const;// 当前局面的Zobrist键值
+    inline static int toSquare(def::TPos pos);
+    inline static def::TPos toPos(int sq);
+    inline static def::TMove toMove(uint16_t move);
+    inline static int getColor(def::PLAYER_E player);// 红方0，黑方1
+
+private:
+    template <typename Board>
+    friend void board::getPV(Board& board, const TransTable& tt, uint16_t move, int maxLen, std::vector<uint16_t>& pv);
+
+    struct TRecord
+    {
+        uint16_t move;   // 当前走法
+        uint8_t  capture;// 走棋后dst坐标被捕获的棋子
+        uint8_t  check;  // 走棋后是否能将军，见board::CHECK_E
+        uint64_t key;    // 走棋前局面的Zobrist键值
+    };
+
+private:
+    uint8_t  board_[91];   // 各格子的icon，第90格恒为空，作为无效马腿、象眼的下标
+    TBits    pieces_[2][8];// 各方各类棋子的位集合，第二维为PIECE_E，[x][0]为该方所有棋子
+    TBits    occupied_;    // 所有棋子
+    uint16_t rankOcc_[10]; // 各行的占用位，第col位表示第col列
+    uint16_t fileOcc_[9];  // 各列的占用位，第row位表示第row行
+    uint8_t  kings_[2];    // 双方将的格子
+
+    int redScore_;
+    int blackScore_;
+
+    def::PLAYER_E player_;
+    Zobrist zoCurr_;
+    MyStack<TRecord> records_;
+    int distance_;
+
+    uint16_t killers_[64][2];// 每层两个杀手走法
+    int16_t  history_[90][90];// 历史表，以起点、终点为下标，按board::updateHistory有界更新
+
+    shared_ptr<TransTable> tt_;// 置换表，副本之间共享
+    shared_ptr<std::atomic<bool>> stop_;
+    shared_ptr<std::atomic<bool>> ponder_;
+    TimeManager timeManager_;
+    bool timeout_;
+    uint64_t nodes_;
+    int depth_;
+    uint16_t ponderMove_;
+    board::InfoCallback infoCallback_;
+};
+
+#endif // BITBOARD_H
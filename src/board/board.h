@@ -3,6 +3,10 @@
 
 #include "util/def.h"
 
+#include <memory>
+#include <vector>
+#include <functional>
+
 namespace board
 {
     enum MOVE_RET_E
@@ -15,6 +19,19 @@ namespace board
         MOVE_RET_eat     = 0x20,// 吃子
     };
 
+    // 迭代加深每完成一层发布的搜索信息
+    struct TSearchInfo
+    {
+        int      depth;             // 完成的深度
+        int      score;             // 相对于走棋方的分数
+        uint64_t nodes;             // 主线程的节点数
+        uint64_t nps;               // 主线程每秒节点数
+        double   seconds;           // 已用时间
+        std::vector<def::TMove> pv; // 主要变例
+    };
+
+    typedef std::function<void(const TSearchInfo&)> InfoCallback;
+
     struct IBoard
     {
         virtual ~IBoard(){}
@@ -24,6 +41,13 @@ namespace board
         virtual uint8_t makeMove(def::TMove move) = 0;              // 指定走法走棋,返回EMoveRet的组合
         virtual bool undoMakeMove() = 0;                            // 悔棋
 
+        virtual std::shared_ptr<IBoard> clone() const = 0;          // 复制当前局面，供后台线程搜索
+        virtual bool searchMove(def::TMove& move) = 0;              // 搜索最佳走法但不走棋，被中止则返回false
+        virtual void stopSearch() = 0;                              // 中止正在进行的searchMove，可在其他线程调用
+        virtual void setPonder(bool on) = 0;                        // 后台思考模式下searchMove不受时间限制，解除后计入已用时间，可在其他线程调用
+        virtual def::TMove getPonderMove() const = 0;               // 最近一次searchMove预测的对方应着，没有则为无效走法
+        virtual void setInfoCallback(const InfoCallback& callback) = 0;// 每完成一层迭代在搜索线程中回调，用于显示主要变例
+
         virtual int getScore(def::PLAYER_E player) const = 0;       // 获取当前局面下的玩家分数
         virtual def::ICON_E getIcon(def::TPos pos) const = 0;       // 获取某一位置的棋子
         virtual def::PLAYER_E getOwner(def::TPos pos) const = 0;    // 获取pos棋子所属玩家
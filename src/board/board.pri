@@ -1,9 +1,21 @@
 SOURCES += \
     $$PWD/slimboard.cpp \
-    $$PWD/naiveboard.cpp
+    $$PWD/bitboard.cpp \
+    $$PWD/valuetable.cpp \
+    $$PWD/slidetable.cpp \
+    $$PWD/naiveboard.cpp \
+    $$PWD/transtable.cpp \
+    $$PWD/timemanager.cpp
 
 HEADERS += \
     $$PWD/board.h \
     $$PWD/slimboard.h \
-    $$PWD/naiveboard.h 
+    $$PWD/bitboard.h \
+    $$PWD/valuetable.h \
+    $$PWD/slidetable.h \
+    $$PWD/searchutil.h \
+    $$PWD/naiveboard.h \
+    $$PWD/movelist.h \
+    $$PWD/transtable.h \
+    $$PWD/timemanager.h
 
@@ -0,0 +1,140 @@
+#ifndef MOVELIST_H
+#define MOVELIST_H
+
+#include <stdint.h>
+#include <assert.h>
+
+// 定长走法列表，分配在栈上，避免搜索节点中的堆分配
+// 每个走法附带一个排序分值
+class MoveList
+{
+public:
+    // 伪合法走法数的上限：车、炮各2个最多各17步，马2×8，兵5×3，将4，士、象各2×4，合计119
+    static const int CAPACITY = 128;
+
+public:
+    MoveList()
+        : size_(0)
+    {
+
+    }
+
+    void clear()
+    {
+        size_ = 0;
+    }
+
+    void push(uint16_t move, int score = 0)
+    {
+        assert(size_ < CAPACITY);
+        moves_[size_] = move;
+        scores_[size_] = score;
+        size_++;
+    }
+
+    int size() const
+    {
+        return size_;
+    }
+
+    bool empty() const
+    {
+        return size_ == 0;
+    }
+
+    uint16_t getMove(int i) const
+    {
+        return moves_[i];
+    }
+
+    int getScore(int i) const
+    {
+        return scores_[i];
+    }
+
+    void setScore(int i, int score)
+    {
+        scores_[i] = score;
+    }
+
+    void swap(int i, int j)
+    {
+        uint16_t move = moves_[i];
+        moves_[i] = moves_[j];
+        moves_[j] = move;
+
+        int score = scores_[i];
+        scores_[i] = scores_[j];
+        scores_[j] = score;
+    }
+
+    // 按分值从高到低排序，走法数很少，插入排序即可
+    void sort()
+    {
+        for (int i = 1; i < size_; i++)
+        {
+            uint16_t move = moves_[i];
+            int score = scores_[i];
+            int j = i - 1;
+
+            while (j >= 0 && scores_[j] < score)
+            {
+                moves_[j + 1] = moves_[j];
+                scores_[j + 1] = scores_[j];
+                j--;
+            }
+
+            moves_[j + 1] = move;
+            scores_[j + 1] = score;
+        }
+    }
+
+    // 选出[from, size)中分值最高的走法交换到from，用于只需要前几个走法的场合
+    void pickBest(int from)
+    {
+        int best = from;
+
+        for (int i = from + 1; i < size_; i++)
+        {
+            if (scores_[i] > scores_[best])
+            {
+                best = i;
+            }
+        }
+
+        if (best != from)
+        {
+            swap(from, best);
+        }
+    }
+
+    bool contains(uint16_t move) const
+    {
+        for (int i = 0; i < size_; i++)
+        {
+            if (moves_[i] == move)
+            {
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    const uint16_t* begin() const
+    {
+        return moves_;
+    }
+
+    const uint16_t* end() const
+    {
+        return moves_ + size_;
+    }
+
+private:
+    uint16_t moves_[CAPACITY];
+    int      scores_[CAPACITY];
+    int      size_;
+};
+
+#endif // MOVELIST_H
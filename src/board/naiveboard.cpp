@@ -58,22 +58,61 @@ def::TMove NaiveBoard::getTrigger() const
 }
 
 uint8_t NaiveBoard::autoMove()
+{
+    TMove move = def::INVALID_MOVE;
+
+    searchMove(move);
+
+    makeMove(move);
+    return true;
+}
+
+// 复制当前局面，快照需深拷贝，历史快照只读可共享
+shared_ptr<board::IBoard> NaiveBoard::clone() const
+{
+    shared_ptr<NaiveBoard> board = std::make_shared<NaiveBoard>(*this);
+    board->snapshot_ = std::make_shared<Snapshot>(*snapshot_);
+    return board;
+}
+
+// 搜索最佳走法但不走棋
+bool NaiveBoard::searchMove(TMove& move)
 {
     int alpha = INT_MIN;
     int beta = INT_MAX;
     int score = 0;
     int depth = 3;
-    TMove move = def::INVALID_MOVE;
 
     score = minimax(depth, getNextPlayer(), move);
    // debug::printBoard(snapshot_->board_);
     score = alphabeta(depth, getNextPlayer(), alpha, beta, move);
     //debug::printBoard(snapshot_->board_);
 
-    makeMove(move);
     return true;
 }
 
+// 浅层搜索很快结束，无需中止
+void NaiveBoard::stopSearch()
+{
+
+}
+
+// 固定深度搜索，不受时间限制影响
+void NaiveBoard::setPonder(bool /*on*/)
+{
+
+}
+
+def::TMove NaiveBoard::getPonderMove() const
+{
+    return def::INVALID_MOVE;
+}
+
+void NaiveBoard::setInfoCallback(const board::InfoCallback& /*callback*/)
+{
+
+}
+
 void NaiveBoard::generateAllMoves(vector<def::TMove>& moves)
 {
     moves.clear();
@@ -30,6 +30,13 @@ public:
     virtual uint8_t makeMove(def::TMove move);              // 指定走法走棋,返回EMoveRet的组合
     virtual bool undoMakeMove();                            // 悔棋
 
+    virtual shared_ptr<board::IBoard> clone() const;        // 复制当前局面，供后台线程搜索
+    virtual bool searchMove(def::TMove& move);              // 搜索最佳走法但不走棋，被中止则返回false
+    virtual void stopSearch();                              // 中止正在进行的搜索，可在其他线程调用
+    virtual void setPonder(bool on);                        // 后台思考模式，固定深度搜索不受影响
+    virtual def::TMove getPonderMove() const;               // 不预测对方应着
+    virtual void setInfoCallback(const board::InfoCallback& callback);// 不是迭代加深，不回调
+
     virtual int getScore(def::PLAYER_E player) const;        // 获取当前局面下的玩家分数
     virtual def::ICON_E getIcon(def::TPos pos) const;      // 获取某一位置的棋子
     virtual def::PLAYER_E getNextPlayer() const;             // 获取下一走棋玩家
@@ -0,0 +1,171 @@
+#ifndef SEARCHUTIL_H
+#define SEARCHUTIL_H
+
+#include "board/transtable.h"
+#include "util/mystack.h"
+
+#include <stdint.h>
+
+#include <vector>
+#include <algorithm>
+#include <cstdlib>
+
+// SlimBoard与BitBoard共用的搜索规则：杀棋分数、重复局面的判定、历史分值的更新、主要变例的提取
+// 两个引擎对同一局面必须给出相同的胜负判断，这些规则只在此处实现
+namespace board
+{
+    const int SCORE_CHECKMATE   = 10000;// 将死对方的分数
+    const int SCORE_WIN         = 9900; // 分数大于此界限均为胜利
+    const int SCORE_DRAW        = 20;   // 和棋对当前玩家略为不利，避免在占优时求和
+    const int HISTORY_MAX       = 16384;// 历史分值的上限
+    const int HISTORY_BONUS_MAX = 1200; // 单次更新的上限
+
+    // 历史记录中走棋后是否将军对方
+    enum CHECK_E
+    {
+        CHECK_no,
+        CHECK_yes,
+        CHECK_unknown,// 尚未计算
+    };
+
+    // 杀棋分数与距离根节点的步数有关，存入置换表时需转换为相对于当前节点的分数
+    inline int scoreToTT(int score, int distance)
+    {
+        if (score > SCORE_WIN)
+        {
+            return score + distance;
+        }
+        else if (score < -SCORE_WIN)
+        {
+            return score - distance;
+        }
+
+        return score;
+    }
+
+    inline int scoreFromTT(int score, int distance)
+    {
+        if (score > SCORE_WIN)
+        {
+            return score - distance;
+        }
+        else if (score < -SCORE_WIN)
+        {
+            return score + distance;
+        }
+
+        return score;
+    }
+
+    // 按bonus更新历史分值：h += bonus - h * |bonus| / max，分值越接近上限变化越慢，不会溢出
+    inline void updateHistory(int16_t& history, int bonus)
+    {
+        history += bonus - history * std::abs(bonus) / HISTORY_MAX;
+    }
+
+    /*
+        从历史记录的顶部向下查找当前局面第count次出现，吃子或空着之前的局面不再比较，
+        TRecord需有move、capture、check(见CHECK_E)、key(走棋前的键值)，顶部是上一玩家的走法
+        A. 返回0，表示没有重复局面；
+        B. 返回1，表示存在重复局面，但双方都无长将(判和)；
+        C. 返回3(=1+2)，表示存在重复局面，本方单方面长将(判本方负)；
+        D. 返回5(=1+4)，表示存在重复局面，对方单方面长将(判对方负)；
+        E. 返回7(=1+2+4)，表示存在重复局面，双方长将(判和)。
+    */
+    template <typename TRecord>
+    int detectRepeat(const MyStack<TRecord>& records, uint64_t key, int count)
+    {
+        bool self = false; // 顶部是上一玩家的走法
+        bool selfPerpetualCheck = true;
+        bool ememyPerpetualCheck = true;
+
+        for (int i = static_cast<int>(records.size()) - 1; i >= 0; --i) // 由底向上搜索
+        {
+            const TRecord& record = records.at(i);
+
+            if (record.capture != 0 || record.move == 0) // 有吃子或空着即可结束搜索
+            {
+                break;
+            }
+
+            if (self)
+            {
+                selfPerpetualCheck = selfPerpetualCheck && record.check == CHECK_yes;
+
+                if (record.key == key)
+                {
+                    if (--count == 0)
+                    {
+                        return 1 + (selfPerpetualCheck ? 2 : 0) + (ememyPerpetualCheck ? 4 : 0);
+                    }
+                }
+            }
+            else
+            {
+                ememyPerpetualCheck = ememyPerpetualCheck && record.check == CHECK_yes;
+            }
+
+            self = !self;
+        }
+
+        return 0;
+    }
+
+    // 重复局面相对于当前玩家的分数：单方面长将的一方判负，否则判和
+    inline int getRepeatScore(int status, int distance)
+    {
+        int res = 0;
+
+        if (status & 2)
+        {
+            res += distance - SCORE_CHECKMATE;
+        }
+
+        if (status & 4)
+        {
+            res += SCORE_CHECKMATE - distance;
+        }
+
+        if (res == 0)
+        {
+            res = -SCORE_DRAW;
+        }
+
+        return res;
+    }
+
+    // 从置换表中依次取出最佳走法得到以move开始的主要变例，遇到重复局面或非法走法即停止，返回前还原局面
+    // Board需提供doMove(move)、undoMove()、isValidMove(move)及getKey()，并将本函数声明为友元
+    template <typename Board>
+    void getPV(Board& board, const TransTable& tt, uint16_t move, int maxLen, std::vector<uint16_t>& pv)
+    {
+        std::vector<uint64_t> keys;
+        pv.clear();
+
+        while (move != 0 && static_cast<int>(pv.size()) < maxLen && board.doMove(move))
+        {
+            pv.push_back(move);
+
+            uint64_t key = board.getKey();
+            if (std::find(keys.begin(), keys.end(), key) != keys.end()) // 循环
+            {
+                break;
+            }
+            keys.push_back(key);
+
+            TransTable::TEntry entry;
+            move = 0;
+            if (tt.probe(key, entry) && entry.move != 0 && board.isValidMove(entry.move))
+            {
+                move = entry.move;
+            }
+        }
+
+        for (size_t i = 0; i < pv.size(); i++)
+        {
+            board.undoMove();
+        }
+    }
+}
+
+#endif // SEARCHUTIL_H
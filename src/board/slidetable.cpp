@@ -0,0 +1,65 @@
+#include "slidetable.h"
+
+namespace board
+{
+    TSlide g_rankSlides[9][512];
+    TSlide g_fileSlides[10][1024];
+
+    // 一行(列)上位置pos的车、炮走法，count为该行(列)的格子数
+    static TSlide makeSlide(int pos, int occ, int count)
+    {
+        TSlide slide = {0, 0, 0};
+
+        for (int dir = -1; dir <= 1; dir += 2)
+        {
+            int i = pos + dir;
+
+            while (i >= 0 && i < count && (occ & (1 << i)) == 0)
+            {
+                slide.quiet |= 1 << i;
+                i += dir;
+            }
+
+            if (i >= 0 && i < count)
+            {
+                slide.rookCapture |= 1 << i;
+
+                i += dir;
+                while (i >= 0 && i < count && (occ & (1 << i)) == 0)
+                {
+                    i += dir;
+                }
+
+                if (i >= 0 && i < count)
+                {
+                    slide.cannonCapture |= 1 << i;
+                }
+            }
+        }
+
+        return slide;
+    }
+
+    static bool initSlideTables()
+    {
+        for (int pos = 0; pos < 9; pos++)
+        {
+            for (int occ = 0; occ < 512; occ++)
+            {
+                g_rankSlides[pos][occ] = makeSlide(pos, occ, 9);
+            }
+        }
+
+        for (int pos = 0; pos < 10; pos++)
+        {
+            for (int occ = 0; occ < 1024; occ++)
+            {
+                g_fileSlides[pos][occ] = makeSlide(pos, occ, 10);
+            }
+        }
+
+        return true;
+    }
+
+    static const bool g_slideTablesInited = initSlideTables();
+}
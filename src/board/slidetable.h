@@ -0,0 +1,48 @@
+#ifndef SLIDETABLE_H
+#define SLIDETABLE_H
+
+#include <stdint.h>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace board
+{
+    // 车、炮在一行(列)上的走法，以棋子所在的位置和该行(列)的占用位为下标，结果为该行(列)上的位
+    struct TSlide
+    {
+        uint16_t quiet;        // 不吃子可到达的空位
+        uint16_t rookCapture;  // 两侧的第一个棋子
+        uint16_t cannonCapture;// 两侧炮架之后的第一个棋子
+    };
+
+    extern TSlide g_rankSlides[9][512]; // 行上第col列的走法，占用位第i位表示第i列
+    extern TSlide g_fileSlides[10][1024];// 列上第row行的走法，占用位第i位表示第i行
+
+    // 最低位的序号，bits不能为0
+    inline int getFirstBit(uint32_t bits)
+    {
+#if defined(_MSC_VER)
+        unsigned long idx;
+        _BitScanForward(&idx, bits);
+        return static_cast<int>(idx);
+#else
+        return __builtin_ctz(bits);
+#endif
+    }
+
+    // 最高位的序号，bits不能为0
+    inline int getLastBit(uint32_t bits)
+    {
+#if defined(_MSC_VER)
+        unsigned long idx;
+        _BitScanReverse(&idx, bits);
+        return static_cast<int>(idx);
+#else
+        return 31 - __builtin_clz(bits);
+#endif
+    }
+}
+
+#endif // SLIDETABLE_H
@@ -1,30 +1,188 @@
 #include <algorithm>
 #include <assert.h>
+#include <limits.h>
+#include <math.h>
+#include <stdlib.h>
 #include <memory.h>
-#include <time.h>
+#include <chrono>
+#include <thread>
 
 #include "slimboard.h"
+#include "valuetable.h"
+#include "slidetable.h"
 
 using namespace std;
 
 static const int8_t g_deltaKing[4]      = {-16,  -1,  1, 16};
 static const int8_t g_deltaAdvisor[4]   = {-17, -15, 15, 17};
 static const int8_t g_deltaKnight[4][2] = {{-33, -31}, {-18, 14}, {-14, 18}, {31, 33}};// 马的正常delta
+static const int8_t g_deltaKnightCheck[4][2] = {{-33, -18}, {-31, -14}, {14, 31}, {18, 33}};// 能将军的马相对于将的delta，马腿为将加上g_deltaAdvisor
 
-static const int g_scoreCheckmate  = 10000;// 将死对方的分数
-static const int g_scoreWin        = 9900; // 分数大于此界限均为胜利
-static const int g_scoreDraw       = 20;
+static const int g_scoreCheckmate  = board::SCORE_CHECKMATE;// 将死对方的分数
+static const int g_scoreWin        = board::SCORE_WIN;       // 分数大于此界限均为胜利
+static const int g_scoreDraw       = board::SCORE_DRAW;
 static const int g_maxDepth        = 32;   // 最大递归深度
+static const int g_maxPly          = 64;   // 杀手走法表的层数
+static const int g_deltaMargin     = 50;   // 静态搜索delta剪枝的余量
+static const int g_aspirationWindow = 25;  // 渴望窗口的初始半宽
+static const int g_aspirationDepth  = 4;   // 从此深度开始使用渴望窗口
+static const int g_nullMinDepth     = 2;   // 空着裁剪的最小深度
+static const int g_nullVerifyDepth  = 6;   // 从此深度开始，空着裁剪需要验证搜索
+static const int g_maxExtensions    = 8;    // 每条路线上将军延伸的最大层数
+static const int g_historyBonusMax  = board::HISTORY_BONUS_MAX;// 单次更新的上限
+static const int g_repeatMask       = 4095; // 重复局面计数表的下标掩码
+static const int g_cuckooSize       = 8192; // 可逆走法表的大小
+
+// 余量以getValue的子力分值为尺度：兵过河约增值30，马、炮约100，车约200
+static const SlimBoard::TSearchParams g_defaultParams = {3, 3, 0.5, 2.25, 3, 3, 3, 70, 2, 100, 6, 2};
+
+// 棋子列表中各类棋子的序号范围[起始, 结束)，相对于玩家的起始序号：将0，士1~2，象3~4，马5~6，车7~8，炮9~10，兵11~15
+static const uint8_t g_pieceSlots[8][2] = {{0, 0}, {0, 1}, {1, 3}, {3, 5}, {5, 7}, {7, 9}, {9, 11}, {11, 16}};
+
+// 玩家在棋子列表中的起始序号，红方16，黑方32
+static inline int getPieceBase(def::PLAYER_E player)
+{
+    return player << 1;
+}
 
-static const Zobrist g_zoPlayer;
-static const Zobrist g_zoTable[14][256];
+static Zobrist g_zoPlayer;
+static Zobrist g_zoTable[14][256];// 红方icon 9~15对应0~6，黑方icon 17~23对应7~13
+
+// icon对应的Zobrist键值
+static inline const Zobrist& getZobrist(def::ICON_E icon, uint8_t idx)
+{
+    return g_zoTable[(icon & def::PLAYER_MASK) == def::PLAYER_red ? icon - 9 : icon - 10][idx];
+}
 
-static int g_cnt = 0;
+// 可逆走法的布谷鸟表：以一步走法前后局面键值之差为键，用于判断当前局面能否一步回到之前的局面
+// 吃子不可逆，兵(卒)不能后退，均不在表中；走法以较小的坐标为起点
+static uint64_t g_cuckooKeys[g_cuckooSize];
+static uint16_t g_cuckooMoves[g_cuckooSize];
+static uint8_t  g_cuckooIcons[g_cuckooSize];
 
+static inline int cuckooHash1(uint64_t key)
+{
+    return key & (g_cuckooSize - 1);
+}
 
-SlimBoard::SlimBoard()
+static inline int cuckooHash2(uint64_t key)
+{
+    return (key >> 16) & (g_cuckooSize - 1);
+}
+
+// 空棋盘上棋子能否在a、b之间往返，a、b均在棋盘内
+static bool isReversibleSpan(def::ICON_E icon, int a, int b)
+{
+    int dr = abs((a >> 4) - (b >> 4));
+    int dc = abs((a & 15) - (b & 15));
+    bool red = def::extractOwner(icon) == def::PLAYER_red;
+
+    // 九宫：第6~8列，黑方第3~5行，红方第10~12行；己方半边：黑方第3~7行，红方第8~12行
+    auto inSquare = [red](int idx) { int r = idx >> 4, c = idx & 15; return c >= 6 && c <= 8 && (red ? r >= 10 : r <= 5); };
+    auto inHome = [red](int idx) { return red ? (idx >> 4) >= 8 : (idx >> 4) <= 7; };
+
+    switch (def::extractPiece(icon))
+    {
+        case def::PIECE_king:
+            return dr + dc == 1 && inSquare(a) && inSquare(b);
+        case def::PIECE_advisor:
+            return dr == 1 && dc == 1 && inSquare(a) && inSquare(b);
+        case def::PIECE_bishop:
+            return dr == 2 && dc == 2 && inHome(a) && inHome(b);
+        case def::PIECE_knight:
+            return (dr == 1 && dc == 2) || (dr == 2 && dc == 1);
+        case def::PIECE_rook:
+        case def::PIECE_cannon:
+            return (dr == 0) != (dc == 0);
+        default:
+            return false;
+    }
+}
+
+static void initCuckooTable()
+{
+    static const def::PLAYER_E players[2] = {def::PLAYER_red, def::PLAYER_black};
+
+    for (def::PLAYER_E player: players)
+    {
+        for (int piece = def::PIECE_king; piece <= def::PIECE_cannon; piece++)
+        {
+            def::ICON_E icon = def::synthesisIcon(player, static_cast<def::PIECE_E>(piece));
+
+            for (int a = 51; a <= 203; a++)
+            {
+                for (int b = a + 1; b <= 203; b++)
+                {
+                    if ((a & 15) < 3 || (a & 15) > 11 || (b & 15) < 3 || (b & 15) > 11 || !isReversibleSpan(icon, a, b))
+                    {
+                        continue;
+                    }
+
+                    Zobrist zobr;
+                    zobr.Xor(getZobrist(icon, a), getZobrist(icon, b));
+                    zobr.Xor(g_zoPlayer);
+
+                    // 布谷鸟插入：占用的位置把原表项挤到它的另一个位置，直到遇到空位
+                    uint64_t key = zobr.getKey();
+                    uint16_t move = static_cast<uint16_t>(a | (b << 8));
+                    uint8_t pieceIcon = static_cast<uint8_t>(icon);
+                    int i = cuckooHash1(key);
+
+                    while (move != 0)
+                    {
+                        std::swap(g_cuckooKeys[i], key);
+                        std::swap(g_cuckooMoves[i], move);
+                        std::swap(g_cuckooIcons[i], pieceIcon);
+                        i = (i == cuckooHash1(key)) ? cuckooHash2(key) : cuckooHash1(key);
+                    }
+                }
+            }
+        }
+    }
+}
+
+// 用同一个密码流依次填充所有键值，保证各键值互不相同
+static bool initZobristTable()
 {
+    RC4 rc4;
+
+    g_zoPlayer = Zobrist(rc4);
+    for (int i = 0; i < 14; i++)
+    {
+        for (int j = 0; j < 256; j++)
+        {
+            g_zoTable[i][j] = Zobrist(rc4);
+        }
+    }
+
+    initCuckooTable();
+
+    return true;
+}
+
+static const bool g_zoInited = initZobristTable();
 
+static const int g_mvvLva[8] = {0, 5, 1, 1, 3, 4, 3, 2}; // 空 将 仕 象 马 车 炮 卒
+
+SlimBoard::SlimBoard()
+    : tt_(std::make_shared<TransTable>())
+    , threadNum_(std::max(1u, std::thread::hardware_concurrency()))
+    , nodes_(0)
+    , cutoffs_(0)
+    , firstCutoffs_(0)
+    , depth_(0)
+    , extensions_(0)
+    , nullMinPly_(0)
+    , nullPlayer_(def::PLAYER_none)
+    , stop_(std::make_shared<std::atomic<bool>>(false))
+    , pollLimits_(false)
+    , timeout_(false)
+    , ponder_(std::make_shared<std::atomic<bool>>(false))
+    , ponderMove_(0)
+    , stats_()
+{
+    memset(pvLength_, 0, sizeof(pvLength_));
+    setSearchParams(g_defaultParams);
 }
 
 // 开局
@@ -51,7 +209,10 @@ void SlimBoard::init()
     
     // 初始化棋盘
     memcpy(board_, initBoard, sizeof(board_));
-    memset(cache_, 0, sizeof(cache_));
+    // 清空走法排序使用的各个表
+    memset(history_, 0, sizeof(history_));
+    memset(killers_, 0, sizeof(killers_));
+    memset(counters_, 0, sizeof(counters_));
     // 递归层数
     distance_ = 0;
     // 双王起始位置
@@ -59,13 +220,16 @@ void SlimBoard::init()
     blackKingIdx_ = 55;
     // 计算双方起始分数
     initScore();
+    initPieces();
 
     winner_ = def::PLAYER_none;
     player_ = def::PLAYER_red;
     // 清空历史记录
     records_.clear();
-
-    zoCurr_.clear();
+    memset(repeatCounts_, 0, sizeof(repeatCounts_));
+    // 计算起始局面的Zobrist键值，并清空置换表
+    initZobrist();
+    tt_->clear();
 }
 
 // 计算双方起始分数
@@ -73,21 +237,48 @@ void SlimBoard::initScore()
 {
     blackScore_ = 0;
     redScore_ = 0;
+    blackAttackers_ = 0;
+    redAttackers_ = 0;
 
     for (int i = 0; i < 256; i++)
     {
         def::ICON_E   icon  = getIcon(i);
         def::PLAYER_E owner = getOwner(i);
+        def::PIECE_E  piece = def::extractPiece(icon);
+        int attacker = (piece == def::PIECE_rook || piece == def::PIECE_knight || piece == def::PIECE_cannon) ? 1 : 0;
 
         if (owner == def::PLAYER_black)
         {
             blackScore_ += getValue(icon, i);
+            blackAttackers_ += attacker;
         }
         else if (owner == def::PLAYER_red)
         {
             redScore_ += getValue(icon, i);
+            redAttackers_ += attacker;
+        }
+    }
+}
+
+// 计算当前局面的Zobrist键值
+void SlimBoard::initZobrist()
+{
+    zoCurr_.clear();
+
+    for (int i = 0; i < 256; i++)
+    {
+        def::ICON_E icon = getIcon(i);
+
+        if (def::extractOwner(icon) != def::PLAYER_none)
+        {
+            zoCurr_.Xor(getZobrist(icon, i));
         }
     }
+
+    if (player_ == def::PLAYER_black)
+    {
+        zoCurr_.Xor(g_zoPlayer);
+    }
 }
 
 // 悔棋
@@ -98,13 +289,7 @@ bool SlimBoard::undoMakeMove()
         return false;
     }
 
-    SlimBoard::TRecord record = records_.top();
-    records_.pop();
-    undoMovePiece(record.move, record.capture);
-    
-    def::switchPlayer(player_);
-
-    distance_--;// 减少与根节点的距离
+    undoMove();
 
     return true;
 }
@@ -112,20 +297,55 @@ bool SlimBoard::undoMakeMove()
 // 电脑计算走棋
 uint8_t SlimBoard::autoMove()
 {
-    int depth = 7;
-    uint16_t move;
+    def::TMove move = def::INVALID_MOVE;
+
+    if (!searchMove(move))
+    {
+        return 0;
+    }
+
+    return makeMove(move);
+}
+
+// 复制当前局面，副本与原棋盘共享置换表，但使用独立的中止标志
+shared_ptr<board::IBoard> SlimBoard::clone() const
+{
+    shared_ptr<SlimBoard> board = std::make_shared<SlimBoard>(*this);
+    board->stop_ = std::make_shared<std::atomic<bool>>(false);
+    board->ponder_ = std::make_shared<std::atomic<bool>>(false);
+    return board;
+}
 
-//    int a = minimax(depth, player_, &move);
+// 搜索最佳走法但不走棋，搜索时间由timeManager_的限制决定
+bool SlimBoard::searchMove(def::TMove& move)
+{
+//    int depth = 7;
+//    uint16_t innerMove = 0;
 //
-//    int b = negamax(depth, &move);
+//    int a = minimax(depth, player_, &innerMove);
 //
-//    int c = alphabeta(depth, player_, INT_MIN, INT_MAX, &move);
+//    int b = negamax(depth, &innerMove);
 //
-    int d = alphabetaWithNega(depth, -g_scoreCheckmate, g_scoreCheckmate, &move);
+//    int c = alphabeta(depth, player_, INT_MIN, INT_MAX, &innerMove);
 //
-//    move = fullSearch();
+//    int d = alphabetaWithNega(depth, -g_scoreCheckmate, g_scoreCheckmate, &innerMove);
 
-    return makeMove(move);
+    uint16_t innerMove = fullSearch();
+    ponderMove_ = 0;
+
+    if (innerMove == 0) // 被中止或无棋可走
+    {
+        return false;
+    }
+
+    // 主要变例中最佳走法之后的对方应着，供后台思考使用
+    if (pv_.size() > 1 && pv_[0] == innerMove)
+    {
+        ponderMove_ = pv_[1];
+    }
+
+    move = toMove(innerMove);
+    return true;
 }
 
 // 相对于player的评估函数
@@ -142,7 +362,7 @@ int SlimBoard::minimax(int depth, def::PLAYER_E maxPlayer, uint16_t* pNextMove)
         return evaluate(maxPlayer); // 评价函数是相对于 极大方 的
     }
 
-    vector<uint16_t> moves;
+    MoveList moves;
     generateAllMoves(moves);
 
     if (getNextPlayer() == maxPlayer) // 极大节点
@@ -151,10 +371,10 @@ int SlimBoard::minimax(int depth, def::PLAYER_E maxPlayer, uint16_t* pNextMove)
 
         for (uint16_t move: moves)
         {
-            if (makeMove(move) & board::MOVE_RET_ok) // move可能导致自杀
+            if (doMove(move)) // move可能导致自杀
             {
                 int val = minimax(depth - 1, maxPlayer, nullptr);
-                undoMakeMove();
+                undoMove();
 
                 if (val > maxScore)
                 {
@@ -176,10 +396,10 @@ int SlimBoard::minimax(int depth, def::PLAYER_E maxPlayer, uint16_t* pNextMove)
 
         for (uint16_t move: moves)
         {
-            if (makeMove(move) & board::MOVE_RET_ok) // move可能导致自杀
+            if (doMove(move)) // move可能导致自杀
             {
                 int val = minimax(depth - 1, maxPlayer, nullptr);
-                undoMakeMove();
+                undoMove();
 
                 if (val < minScore)
                 {
@@ -205,17 +425,17 @@ int SlimBoard::negamax(int depth, uint16_t* pNextMove)
         return evaluate(getNextPlayer()); // 评价函数是相对于 当前玩家 的
     }
 
-    vector<uint16_t> moves;
+    MoveList moves;
     generateAllMoves(moves);
 
     int maxScore = INT_MIN;
 
     for (uint16_t move: moves)
     {
-        if (makeMove(move) & board::MOVE_RET_ok) // move可能导致自杀
+        if (doMove(move)) // move可能导致自杀
         {
             int val = -negamax(depth - 1, nullptr);
-            undoMakeMove();
+            undoMove();
 
             if (val > maxScore)
             {
@@ -240,7 +460,7 @@ int SlimBoard::alphabeta(int depth, def::PLAYER_E maxPlayer, int alpha, int beta
         return evaluate(maxPlayer); // 评价函数是相对于 极大方 的
     }
 
-    vector<uint16_t> moves;
+    MoveList moves;
     generateAllMoves(moves);
 
     if (player_ == maxPlayer) // 极大节点
@@ -249,10 +469,10 @@ int SlimBoard::alphabeta(int depth, def::PLAYER_E maxPlayer, int alpha, int beta
 
         for (uint16_t move: moves)
         {
-            if (makeMove(move) & board::MOVE_RET_ok)
+            if (doMove(move))
             {
                 int val = alphabeta(depth - 1, maxPlayer, maxScore, beta, nullptr);
-                undoMakeMove();
+                undoMove();
 
                 if (val > maxScore) // 本层为极大节点，取各子节点最大值
                 {
@@ -279,10 +499,10 @@ int SlimBoard::alphabeta(int depth, def::PLAYER_E maxPlayer, int alpha, int beta
 
         for (uint16_t move: moves)
         {
-            if (makeMove(move) & board::MOVE_RET_ok)
+            if (doMove(move))
             {
                 int val = alphabeta(depth - 1, maxPlayer, alpha, minScore, nullptr);
-                undoMakeMove();
+                undoMove();
 
                 if (val < minScore) // 本层为极小节点，取各子节点最小值
                 {
@@ -310,22 +530,27 @@ int SlimBoard::alphabeta(int depth, def::PLAYER_E maxPlayer, int alpha, int beta
 // alpha-bata剪枝与负极大值算法相结合
 int SlimBoard::alphabetaWithNega(int depth, int alpha, int beta, uint16_t* pNextMove)
 {
+    if (isStopped()) // 被中止后尽快返回，结果不再使用
+    {
+        return 0;
+    }
+
     if (depth == 0 || winner_ != def::PLAYER_none)
     {
         return evaluate(player_); // 评价函数是相对于 当前玩家 的
     }
 
-    vector<uint16_t> moves;
+    MoveList moves;
     generateAllMoves(moves);
 
     int maxScore = alpha;
 
     for (uint16_t move: moves)
     {
-        if (makeMove(move) & board::MOVE_RET_ok)
+        if (doMove(move))
         {
             int val = -alphabetaWithNega(depth - 1, -beta, -maxScore, nullptr);
-            undoMakeMove();
+            undoMove();
 
             if (val > maxScore)
             {
@@ -348,221 +573,1478 @@ int SlimBoard::alphabetaWithNega(int depth, int alpha, int beta, uint16_t* pNext
 }
 
 // 迭代加深的alpha-beta完全搜索
+// Lazy SMP：辅助线程在各自的棋盘副本上同时迭代加深，只通过共享的置换表交换信息，返回主线程的结果
 uint16_t SlimBoard::fullSearch()
 {
-    uint16_t move = 0;
+    newSearch();
 
-    memset(cache_, 0, sizeof(cache_));
-    clock_t start = clock();
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
 
-    for (int i = 1; i <= g_maxDepth; i++)
-    {
-        int score = alphabetaWithNegaSearch(i, -g_scoreCheckmate, g_scoreCheckmate, &move);
-
-        if (score > g_scoreWin || score < -g_scoreWin) // 将死对方或被对方将死
-        {
-            break;
-        }
+    // 辅助线程使用独立的中止标志，主线程结束后统一中止
+    shared_ptr<std::atomic<bool>> helperStop = std::make_shared<std::atomic<bool>>(false);
+    vector<shared_ptr<SlimBoard>> helpers;
+    vector<std::thread> threads;
 
-        if ((clock() - start) > CLOCKS_PER_SEC)
-        {
-            break;
-        }
+    for (int i = 1; i < threadNum_; i++)
+    {
+        shared_ptr<SlimBoard> helper = std::make_shared<SlimBoard>(*this);
+        helper->stop_ = helperStop;
+        helper->pollLimits_ = false;
+        helpers.push_back(helper);
+        threads.emplace_back([helper, i]() { helper->iterativeDeepening(i); });
     }
 
-    return move;
-}
+    pollLimits_ = true;
+    uint16_t move = iterativeDeepening(0);
+    pollLimits_ = false;
 
-int SlimBoard::quiescentSearch(int alpha, int beta)
-{
-    // 检查重复局面
-    if (int status = detectRepeat(1))
+    helperStop->store(true);
+    for (std::thread& t: threads)
     {
-        return getRepeatScore(status);
+        t.join();
     }
 
-    // 到达极限递归深度
-    if (distance_ == g_maxDepth)
+    // 统计
+    stats_.threads = threadNum_;
+    stats_.depth = depth_;
+    stats_.nodes = nodes_;
+    uint64_t cutoffs = cutoffs_;
+    uint64_t firstCutoffs = firstCutoffs_;
+    for (const shared_ptr<SlimBoard>& helper: helpers)
     {
-        return evaluate(player_);
+        stats_.nodes += helper->nodes_;
+        cutoffs += helper->cutoffs_;
+        firstCutoffs += helper->firstCutoffs_;
     }
+    stats_.firstCutRate = cutoffs > 0 ? static_cast<double>(firstCutoffs) / cutoffs : 0;
+    stats_.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    stats_.nps = stats_.seconds > 0 ? static_cast<uint64_t>(stats_.nodes / stats_.seconds) : 0;
 
-    int maxScore = -g_scoreCheckmate;
-    vector<uint16_t> moves;
+    // 被外部中止时结果不再使用
+    bool cancelled = stop_->load();
+    stop_->store(false);
+    timeout_ = false;
+
+    return cancelled ? 0 : move;
+}
+
+// 新一轮搜索前的准备
+void SlimBoard::newSearch()
+{
+    // 杀手走法与层数相关，需要清空；历史分值与反驳走法在相邻的搜索之间仍然有效，只衰减历史分值
+    ageHistory();
+    memset(killers_, 0, sizeof(killers_));
+    tt_->newSearch();
+    nodes_ = 0;
+    cutoffs_ = 0;
+    firstCutoffs_ = 0;
+
+    timeManager_.start();
+    timeout_ = false;
+}
+
+// 单个线程的迭代加深，辅助线程错开起始深度以分散搜索
+uint16_t SlimBoard::iterativeDeepening(int threadId)
+{
+    uint16_t move = 0;
+    depth_ = 0;
+    pv_.clear();
+
+    // 搜索期间distance_表示相对于根节点的步数
+    int distance = distance_;
+    distance_ = 0;
 
-    if (isCheck())// 被将军，则生成所有走法
+    // 只有一个合法走法时，主线程完成第一层即可返回
+    int legalCount = 0;
+    if (threadId == 0)
     {
+        MoveList moves;
         generateAllMoves(moves);
-        std::sort(moves.begin(), moves.end(), // 将生成的走法按照历史走法的分值排序，得分高表示之前浅层递归已经记录过的走法，被排到最前
-                  [this](uint16_t v1, uint16_t v2) // 因为相同局面浅一些的搜索可能会更适合剪枝
-                  {
-                      return this->cache_[v1] >= this->cache_[v2];
-                  });
-    }
-    else// 否则先评估
-    {
-        int val = evaluate(player_);
 
-        if (val > maxScore) // 更新alpha
+        for (uint16_t move: moves)
         {
-            maxScore = val;
+            if (doMove(move))
+            {
+                undoMove();
+                legalCount++;
+            }
         }
+    }
+
+    int score = 0;
+
+    for (int i = 1 + (threadId & 1); i <= g_maxDepth; i++)
+    {
+        uint16_t currMove = 0;
+        score = aspirationSearch(i, score, &currMove);
 
-        if (val >= beta) // beta截断
+        if (isStopped()) // 被中止的这一层结果不完整
         {
-            return val;
+            break;
         }
 
-        static int MvvLva[8] = {0, 5, 1, 1, 3, 4, 3, 2}; // 空 将 仕 象 马 车 炮 卒
-        generateAllMoves(moves);
-        std::sort(moves.begin(), moves.end(), // 将生成的走法按照MvvLva逆向排序，先搜索最优吃子方法
-                  [this](uint16_t v1, uint16_t v2)
-                  {
-                      return MvvLva[def::extractPiece(static_cast<def::ICON_E>(extractDst(v1)))] >=
-                             MvvLva[def::extractPiece(static_cast<def::ICON_E>(extractDst(v2)))];
-                  });
-    }
+        move = currMove;
+        depth_ = i;
 
-    // 同alpha-beta类似
-    for (uint16_t move: moves)
-    {
-        if (makeMove(move) & board::MOVE_RET_ok)
+        // 主线程发布这一层的结果
+        if (threadId == 0)
         {
-            int val = -quiescentSearch(-beta, -maxScore);
-            undoMakeMove();
+            getRootPV(pv_);
 
-            if (val > maxScore)
+            if (infoCallback_)
             {
-                maxScore = val;
+                board::TSearchInfo info;
+                info.depth = i;
+                info.score = score;
+                info.nodes = nodes_;
+                info.seconds = timeManager_.elapsed() / 1000.0;
+                info.nps = info.seconds > 0 ? static_cast<uint64_t>(nodes_ / info.seconds) : 0;
+                for (uint16_t pvMove: pv_)
+                {
+                    info.pv.push_back(toMove(pvMove));
+                }
+                infoCallback_(info);
             }
+        }
 
-            if (val >= beta) // beta剪枝
+        if (score > g_scoreWin || score < -g_scoreWin) // 将死对方或被对方将死
+        {
+            break;
+        }
+
+        // 主线程控制时间，辅助线程一直搜索到被中止
+        if (threadId == 0)
+        {
+            timeManager_.onIteration(move, score);
+
+            if (legalCount == 1 || (!ponder_->load() && timeManager_.shouldStop(i, nodes_)))
             {
                 break;
             }
         }
     }
 
-    if (maxScore == -g_scoreCheckmate)// 一步都走不了
-    {
-        maxScore = -g_scoreCheckmate + distance_;
-    }
+    distance_ = distance;
 
-    return maxScore;
+    return move;
 }
 
-int SlimBoard::alphabetaWithNegaSearch(int depth, int alpha, int beta, uint16_t* pNextMove)
+// 渴望窗口：以上一层的分数为中心用窄窗口搜索，失败时向失败的一侧加倍放宽窗口
+int SlimBoard::aspirationSearch(int depth, int score, uint16_t* pNextMove)
 {
-    if (depth == 0 || winner_ != def::PLAYER_none)
+    int delta = g_aspirationWindow;
+    int alpha = -g_scoreCheckmate;
+    int beta = g_scoreCheckmate;
+
+    if (depth >= g_aspirationDepth && score > -g_scoreWin && score < g_scoreWin)
     {
-        return evaluate(player_); // 评价函数是相对于当前玩家的
+        alpha = std::max(score - delta, -g_scoreCheckmate);
+        beta = std::min(score + delta, g_scoreCheckmate);
     }
 
-    vector<uint16_t> moves;
-    generateAllMoves(moves);
-    std::sort(moves.begin(), moves.end(), // 将生成的走法按照历史走法的分值排序，得分高表示之前浅层递归已经记录过的走法，被排到最前
-              [this](uint16_t v1, uint16_t v2) // 因为相同局面浅一些的搜索可能会更适合剪枝
-              {
-                  return this->cache_[v1] >= this->cache_[v2];
-              });
+    while (true)
+    {
+        score = alphabetaWithNegaSearch(depth, alpha, beta, pNextMove);
 
-    int maxScore = -g_scoreCheckmate;
-    uint16_t maxMove = 0;
+        if (isStopped())
+        {
+            break;
+        }
 
-    for (uint16_t move: moves)
+        if (score <= alpha && alpha > -g_scoreCheckmate) // fail-low，窗口已到边界时不再放宽(如根节点被将死)
+        {
+            alpha = std::max(score - delta, -g_scoreCheckmate);
+        }
+        else if (score >= beta && beta < g_scoreCheckmate) // fail-high
+        {
+            beta = std::min(score + delta, g_scoreCheckmate);
+        }
+        else
+        {
+            break;
+        }
+
+        delta *= 2;
+    }
+
+    return score;
+}
+
+// 多主要变例分析：迭代加深，每一层依次搜索lineNum个变例，第k个变例在根节点排除前面变例的走法
+// 各变例共享置换表，后面的变例可以直接利用前面变例搜索过的子树；只使用主线程
+// 不属于IBoard接口，界面和SearchService不使用，供直接持有SlimBoard的代码调用
+void SlimBoard::analyze(int lineNum, vector<TAnalysisLine>& lines)
+{
+    lines.clear();
+    newSearch();
+    depth_ = 0;
+
+    int distance = distance_;
+    distance_ = 0;
+
+    pollLimits_ = true;
+
+    for (int i = 1; i <= g_maxDepth; i++)
     {
-        if (makeMove(move) & board::MOVE_RET_ok)
+        vector<TAnalysisLine> currLines;
+        excluded_.clear();
+
+        for (int k = 0; k < lineNum; k++)
         {
-            int val = -alphabetaWithNegaSearch(depth - 1, -beta, -maxScore, nullptr);
-            undoMakeMove();
+            uint16_t move = 0;
+            int score = aspirationSearch(i, k < static_cast<int>(lines.size()) ? lines[k].score : 0, &move);
 
-            if (val > maxScore) // pv走法 beta走法
+            if (isStopped() || move == 0) // 被中止或没有更多的合法走法
             {
-                maxScore = val;
-                maxMove = move;
+                break;
             }
 
-            if (val >= beta) // beta剪枝
+            excluded_.push(move);
+
+            vector<uint16_t> pv;
+            getRootPV(pv);
+
+            TAnalysisLine line;
+            line.move = toMove(move);
+            line.score = score;
+            line.depth = i;
+            for (uint16_t pvMove: pv)
             {
-                break;
+                line.pv.push_back(toMove(pvMove));
             }
+            currLines.push_back(line);
         }
-    }
 
-    if (maxScore == -g_scoreCheckmate) // 此层无可走的棋，即被将死
-    {
-        maxScore = -g_scoreCheckmate + distance_; // 根据相对于根节点的步数给出评分
-    }
+        if (isStopped() || currLines.empty()) // 被中止的这一层结果不完整
+        {
+            break;
+        }
 
-    if (maxMove != 0) // 可以走棋的话，保存该最佳走法
-    {
-        cache_[maxMove] += depth * depth; // 层数越深，得分越低
+        // 后搜索的变例在窄窗口下可能得到更高的分数，按分数重新排名
+        std::stable_sort(currLines.begin(), currLines.end(),
+                         [](const TAnalysisLine& a, const TAnalysisLine& b) { return a.score > b.score; });
 
-        if (pNextMove != nullptr)
+        lines = currLines;
+        depth_ = i;
+
+        // 重新排名后第一名未必是第一个搜索的变例，稳定性按排名第一的走法及其分数计算
+        uint16_t bestMove = static_cast<uint16_t>(toIndex(lines[0].move.src) | (toIndex(lines[0].move.dst) << 8));
+        timeManager_.onIteration(bestMove, lines[0].score);
+        if (timeManager_.shouldStop(i, nodes_))
         {
-            *pNextMove = maxMove;
+            break;
         }
     }
 
-    return maxScore;
+    pollLimits_ = false;
+    excluded_.clear();
+    distance_ = distance;
+
+    stop_->store(false);
+    timeout_ = false;
 }
 
-// 指定走法走棋
-uint8_t SlimBoard::makeMove(def::TMove move)
+// 从置换表中依次取出最佳走法得到主要变例，遇到重复局面或非法走法即停止
+void SlimBoard::getPV(uint16_t move, vector<uint16_t>& pv)
 {
-    uint8_t srcIdx = toIndex(move.src);
-    uint8_t dstIdx = toIndex(move.dst);
-    uint16_t innerMove = synthesisMove(srcIdx, dstIdx);
+    board::getPV(*this, *tt_, move, g_maxPly, pv);
+}
 
-    if (!isValidMove(innerMove))
-    {
-        return board::MOVE_RET_invalid;
-    }
-    else
+// 三角形表中根节点的主要变例；被置换表截断只剩一步时，改为从置换表中取出
+void SlimBoard::getRootPV(vector<uint16_t>& pv)
+{
+    pv.assign(pvTable_[0], pvTable_[0] + pvLength_[0]);
+
+    if (pv.size() == 1)
     {
-        return makeMove(innerMove);
+        getPV(pv[0], pv);
     }
 }
 
-// 不检查走法是否合法
-uint8_t SlimBoard::makeMove(uint16_t move)
+// 子节点的主要变例已经在下一行，接在move之后复制到本行
+void SlimBoard::updatePV(uint16_t move)
 {
-    uint8_t ret = 0;    
-    
-    uint8_t capture = movePiece(move); // 走棋
-    if (isCheck()) // 走棋是否导致自己被将军
+    if (distance_ + 1 >= g_maxPly)
     {
-        undoMovePiece(move, capture); // 是的话即为自杀
-        ret |= board::MOVE_RET_suicide;
-        return ret;
+        return;
     }
-    
-    def::switchPlayer(player_); // 切换玩家
-    // 注意：一定要切换玩家之后才能判断isCheck
-    records_.push({move, capture, isCheck(), zoCurr_.getKey()}); // 保存历史走法
 
-    ret |= board::MOVE_RET_ok;
+    uint16_t* curr = pvTable_[distance_];
+    const uint16_t* next = pvTable_[distance_ + 1];
+    int length = std::max<int>(pvLength_[distance_ + 1], distance_ + 1);
 
-    if (capture != 0)
+    curr[distance_] = move;
+    for (int i = distance_ + 1; i < length; i++)
     {
-        ret |= board::MOVE_RET_eat;
+        curr[i] = next[i];
     }
+    pvLength_[distance_] = static_cast<uint8_t>(length);
+}
 
-    if (isCheck())
-    {
-        ret |= board::MOVE_RET_check;
+bool SlimBoard::isStopped() const
+{
+    return timeout_ || stop_->load(std::memory_order_relaxed);
+}
 
-        if (isCheckmate())       
-        {
-            ret |= board::MOVE_RET_dead;
+// 只有主线程检查，规则见TimeManager::pollHardLimit
+void SlimBoard::pollLimits()
+{
+    if (pollLimits_ && timeManager_.pollHardLimit(nodes_, depth_, *ponder_))
+    {
+        timeout_ = true;
+    }
+}
+
+// 后台思考模式下搜索不受时间限制；解除后从搜索开始计时，思考期间已用的时间计入本步
+void SlimBoard::setPonder(bool on)
+{
+    ponder_->store(on);
+}
+
+void SlimBoard::setInfoCallback(const board::InfoCallback& callback)
+{
+    infoCallback_ = callback;
+}
+
+def::TMove SlimBoard::getPonderMove() const
+{
+    def::TMove move = def::INVALID_MOVE;
+
+    if (ponderMove_ != 0)
+    {
+        move = toMove(ponderMove_);
+    }
+
+    return move;
+}
+
+// 设置搜索的时间、节点数、深度限制
+void SlimBoard::setSearchLimits(const TimeManager::TLimits& limits)
+{
+    timeManager_.setLimits(limits);
+}
+
+const TimeManager::TLimits& SlimBoard::getSearchLimits() const
+{
+    return timeManager_.getLimits();
+}
+
+// 设置搜索参数，重新计算减少层数表
+void SlimBoard::setSearchParams(const TSearchParams& params)
+{
+    params_ = params;
+
+    for (int depth = 0; depth <= g_maxDepth; depth++)
+    {
+        for (int i = 0; i < MoveList::CAPACITY; i++)
+        {
+            double reduce = (depth == 0 || i == 0) ? 0 : params.lmrBase + log(depth) * log(i) / params.lmrDivisor;
+            reductions_[depth][i] = static_cast<uint8_t>(std::max(0.0, reduce));
+        }
+    }
+}
+
+const SlimBoard::TSearchParams& SlimBoard::getSearchParams() const
+{
+    return params_;
+}
+
+// 设置搜索线程数
+void SlimBoard::setThreadNum(int num)
+{
+    threadNum_ = std::max(1, num);
+}
+
+int SlimBoard::getThreadNum() const
+{
+    return threadNum_;
+}
+
+// 中止正在进行的搜索
+void SlimBoard::stopSearch()
+{
+    stop_->store(true);
+}
+
+// 最近一次fullSearch的统计
+const SlimBoard::TSearchStats& SlimBoard::getSearchStats() const
+{
+    return stats_;
+}
+
+// 分别以1、2、4...maxThreads个线程搜索当前局面，统计nps
+// 注意：每次搜索前都会清空置换表
+void SlimBoard::benchmark(int maxThreads, vector<TSearchStats>& stats)
+{
+    int threadNum = threadNum_;
+    vector<int> counts;
+    stats.clear();
+
+    for (int n = 1; n < maxThreads; n *= 2)
+    {
+        counts.push_back(n);
+    }
+    counts.push_back(std::max(1, maxThreads));
+
+    for (int n: counts)
+    {
+        tt_->clear();
+        setThreadNum(n);
+        fullSearch();
+        stats.push_back(stats_);
+    }
+
+    threadNum_ = threadNum;
+}
+
+// 统计depth层的合法走法路径数，与BitBoard::perft的结果应当相同
+uint64_t SlimBoard::perft(int depth)
+{
+    if (depth == 0)
+    {
+        return 1;
+    }
+
+    MoveList moves;
+    generateLegalMoves(moves);
+
+    if (depth == 1)
+    {
+        return moves.size();
+    }
+
+    uint64_t count = 0;
+    for (uint16_t move: moves)
+    {
+        doMove(move, true);
+        count += perft(depth - 1);
+        undoMove();
+    }
+
+    return count;
+}
+
+// 静态搜索：只搜索吃子走法，直到局面平静，被将军时搜索所有应将走法
+int SlimBoard::quiescentSearch(int alpha, int beta)
+{
+    if (distance_ < g_maxPly) // 静态搜索不收集主要变例
+    {
+        pvLength_[distance_] = static_cast<uint8_t>(distance_);
+    }
+
+    nodes_++;
+    pollLimits();
+
+    if (isStopped())
+    {
+        return 0;
+    }
+
+    // 是否被将军需要在检查重复局面之前确定，长将判断需要用到
+    bool inCheck = givesCheck();
+
+    // 检查重复局面
+    if (int status = detectRepeat(1))
+    {
+        return getRepeatScore(status);
+    }
+
+    // 到达极限递归深度
+    if (distance_ >= g_maxDepth)
+    {
+        return evaluate(player_);
+    }
+
+    // 查找置换表，静态搜索的表项深度为0
+    uint64_t key = zoCurr_.getKey();
+    TransTable::TEntry entry;
+
+    if (tt_->probe(key, entry))
+    {
+        int score = board::scoreFromTT(entry.score, distance_);
+        TransTable::BOUND_E bound = entry.getBound();
+
+        if ((bound == TransTable::BOUND_exact) ||
+            (bound == TransTable::BOUND_lower && score >= beta) ||
+            (bound == TransTable::BOUND_upper && score <= alpha))
+        {
+            return score;
+        }
+    }
+
+    int maxScore = -g_scoreCheckmate;
+    int standPat = -g_scoreCheckmate;
+    uint16_t maxMove = 0;
+    MoveList moves;
+
+    if (inCheck)// 被将军，则生成所有走法
+    {
+        generateAllMoves(moves);
+        for (int i = 0; i < moves.size(); i++) // 将生成的走法按照历史走法的分值排序，得分高表示之前浅层递归已经记录过的走法，被排到最前
+        {
+            moves.setScore(i, getHistory(moves.getMove(i)));
+        }
+        moves.sort();
+    }
+    else// 否则先评估，局面分可作为下界(stand pat)
+    {
+        standPat = evaluate(player_);
+
+        if (standPat > maxScore) // 更新alpha
+        {
+            maxScore = standPat;
+        }
+
+        if (standPat >= beta) // beta截断
+        {
+            tt_->store(key, 0, board::scoreToTT(standPat, distance_), 0, TransTable::BOUND_lower);
+            return standPat;
+        }
+
+        // 只生成吃子走法，价值高的被吃子优先，价值低的吃子方优先
+        generateAllMoves(moves, GEN_capture);
+        for (int i = 0; i < moves.size(); i++)
+        {
+            uint16_t move = moves.getMove(i);
+            def::PIECE_E victim = def::extractPiece(getIcon(extractDst(move)));
+            def::PIECE_E attacker = def::extractPiece(getIcon(extractSrc(move)));
+            moves.setScore(i, g_mvvLva[victim] * 8 - g_mvvLva[attacker]);
+        }
+        moves.sort();
+    }
+
+    TLegalInfo legalInfo;
+    bool legalInited = false;// 走法大多被裁剪，需要判断合法性时才计算
+
+    // 同alpha-beta类似
+    for (uint16_t move: moves)
+    {
+        if (!inCheck)
+        {
+            // delta剪枝：吃掉这个子再加上余量仍然达不到alpha，则不必搜索
+            uint8_t dst = extractDst(move);
+            if (standPat + getValue(getIcon(dst), dst) + g_deltaMargin <= std::max(alpha, maxScore))
+            {
+                continue;
+            }
+
+            // 静态交换评估为负的吃子走法直接剪掉
+            if (!isGoodCapture(move))
+            {
+                continue;
+            }
+        }
+
+        if (!legalInited)
+        {
+            initLegalInfo(legalInfo);
+            legalInited = true;
+        }
+
+        LEGAL_E legal = isLegalMove(move, legalInfo);
+        if (legal == LEGAL_no)
+        {
+            continue;
+        }
+
+        if (doMove(move, legal == LEGAL_yes))
+        {
+            int val = -quiescentSearch(-beta, -std::max(alpha, maxScore));
+            undoMove();
+
+            if (val > maxScore)
+            {
+                maxScore = val;
+                maxMove = move;
+            }
+
+            if (val >= beta) // beta剪枝
+            {
+                break;
+            }
+        }
+    }
+
+    if (isStopped())
+    {
+        return 0;
+    }
+
+    if (maxScore == -g_scoreCheckmate)// 一步都走不了
+    {
+        maxScore = -g_scoreCheckmate + distance_;
+    }
+
+    TransTable::BOUND_E bound = (maxScore >= beta) ? TransTable::BOUND_lower :
+                                (maxScore > alpha) ? TransTable::BOUND_exact : TransTable::BOUND_upper;
+    tt_->store(key, maxMove, board::scoreToTT(maxScore, distance_), 0, bound);
+
+    return maxScore;
+}
+
+// 静态交换评估：双方轮流用价值最低的棋子在dst上吃子，每一方都可以选择停止交换
+// 参与交换的棋子临时从棋盘上拿走并翻转行、列占用位，以便露出后面的车、炮，返回前还原；不考虑牵制
+int SlimBoard::see(uint16_t move)
+{
+    uint8_t src = extractSrc(move);
+    uint8_t dst = extractDst(move);
+
+    int gain[32];          // gain[i]为第i次吃子后，吃子方的累计得失
+    uint8_t removed[32];   // 被临时拿走的棋子坐标
+    uint8_t removedIcon[32];
+    int removedCount = 0;
+    int depth = 0;
+
+    def::ICON_E occupant = getIcon(src);// 当前占据dst的棋子
+    def::PLAYER_E side = def::getEnemyPlayer(def::extractOwner(occupant));
+
+    gain[0] = getValue(getIcon(dst), dst);
+    removed[removedCount] = src;
+    removedIcon[removedCount++] = board_[src];
+    board_[src] = 0;
+    flipOccupancy(src);
+
+    while (uint8_t attacker = getLeastAttacker(dst, side))
+    {
+        def::ICON_E icon = getIcon(attacker);
+        removed[removedCount] = attacker;
+        removedIcon[removedCount++] = board_[attacker];
+        board_[attacker] = 0;
+        flipOccupancy(attacker);
+
+        // 将不能吃到对方仍能攻击的位置
+        if (def::extractPiece(icon) == def::PIECE_king && getLeastAttacker(dst, def::getEnemyPlayer(side)) != 0)
+        {
+            break;
+        }
+
+        depth++;
+        gain[depth] = getValue(occupant, dst) - gain[depth - 1];
+
+        if (std::max(-gain[depth - 1], gain[depth]) < 0) // 无论后续如何交换，结果都不会改变
+        {
+            break;
+        }
+
+        occupant = icon;
+        side = def::getEnemyPlayer(side);
+    }
+
+    while (removedCount > 0) // 还原棋盘
+    {
+        removedCount--;
+        board_[removed[removedCount]] = removedIcon[removedCount];
+        flipOccupancy(removed[removedCount]);
+    }
+
+    while (depth > 0) // 倒推，每一方只在有利时才继续吃子
+    {
+        gain[depth - 1] = -std::max(-gain[depth - 1], gain[depth]);
+        depth--;
+    }
+
+    return gain[0];
+}
+
+// 吃子走法是否不亏子，被吃子价值不低于吃子方时不必计算静态交换
+bool SlimBoard::isGoodCapture(uint16_t move)
+{
+    def::PIECE_E victim = def::extractPiece(getIcon(extractDst(move)));
+    def::PIECE_E attacker = def::extractPiece(getIcon(extractSrc(move)));
+
+    if (g_mvvLva[victim] >= g_mvvLva[attacker])
+    {
+        return true;
+    }
+
+    return see(move) >= 0;
+}
+
+// player攻击dst的价值最低的棋子坐标，按兵、士、象、马、炮、车、将的顺序查找，没有则返回0
+// dst上的棋子不影响判断
+uint8_t SlimBoard::getLeastAttacker(uint8_t dst, def::PLAYER_E player) const
+{
+    // 兵：从后方向前吃，过河后可以左右吃
+    def::ICON_E pawn = def::synthesisIcon(player, def::PIECE_pawn);
+    uint8_t src = dst + 16 - ((player >> 4) << 5); // player >> 4  ->  black: 1 red: 0
+    if (board_[src] == pawn)
+    {
+        return src;
+    }
+
+    if (isAnotherHalf(dst, player))
+    {
+        if (board_[dst - 1] == pawn)
+        {
+            return dst - 1;
+        }
+
+        if (board_[dst + 1] == pawn)
+        {
+            return dst + 1;
+        }
+    }
+
+    // 士：只能在九宫格内
+    if (isInSquare(dst))
+    {
+        def::ICON_E advisor = def::synthesisIcon(player, def::PIECE_advisor);
+        for (int i = 0; i < 4; i++)
+        {
+            if (board_[dst + g_deltaAdvisor[i]] == advisor)
+            {
+                return dst + g_deltaAdvisor[i];
+            }
+        }
+    }
+
+    // 象：不能过河，象眼为空
+    if (isHomeHalf(dst, player))
+    {
+        def::ICON_E bishop = def::synthesisIcon(player, def::PIECE_bishop);
+        for (int i = 0; i < 4; i++)
+        {
+            uint8_t eye = dst + g_deltaAdvisor[i];
+            if (isInBoard(eye) && board_[eye] == 0 && board_[eye + g_deltaAdvisor[i]] == bishop)
+            {
+                return eye + g_deltaAdvisor[i];
+            }
+        }
+    }
+
+    // 马：马腿为空
+    def::ICON_E knight = def::synthesisIcon(player, def::PIECE_knight);
+    for (int i = 0; i < 4; i++)
+    {
+        for (int j = 0; j < 2; j++)
+        {
+            src = dst - g_deltaKnight[i][j];
+            if (board_[src] == knight && board_[src + g_deltaKing[i]] == 0)
+            {
+                return src;
+            }
+        }
+    }
+
+    // 炮、车：查dst所在行、列的占用表，两侧的第一个棋子是车，或者炮架之后的第一个棋子是炮
+    def::ICON_E rook = def::synthesisIcon(player, def::PIECE_rook);
+    def::ICON_E cannon = def::synthesisIcon(player, def::PIECE_cannon);
+    int row = (dst >> 4) - 3;
+    int col = (dst & 15) - 3;
+    const board::TSlide& rank = board::g_rankSlides[col][rankOcc_[row]];
+    const board::TSlide& file = board::g_fileSlides[row][fileOcc_[col]];
+
+    for (uint32_t bits = rank.cannonCapture; bits != 0; bits &= bits - 1)
+    {
+        src = dst + board::getFirstBit(bits) - col;
+        if (board_[src] == cannon)
+        {
+            return src;
+        }
+    }
+
+    for (uint32_t bits = file.cannonCapture; bits != 0; bits &= bits - 1)
+    {
+        src = dst + (board::getFirstBit(bits) - row) * 16;
+        if (board_[src] == cannon)
+        {
+            return src;
+        }
+    }
+
+    for (uint32_t bits = rank.rookCapture; bits != 0; bits &= bits - 1)
+    {
+        src = dst + board::getFirstBit(bits) - col;
+        if (board_[src] == rook)
+        {
+            return src;
+        }
+    }
+
+    for (uint32_t bits = file.rookCapture; bits != 0; bits &= bits - 1)
+    {
+        src = dst + (board::getFirstBit(bits) - row) * 16;
+        if (board_[src] == rook)
+        {
+            return src;
+        }
+    }
+
+    // 将：只能在九宫格内
+    if (isInSquare(dst))
+    {
+        def::ICON_E king = def::synthesisIcon(player, def::PIECE_king);
+        for (int i = 0; i < 4; i++)
+        {
+            if (board_[dst + g_deltaKing[i]] == king)
+            {
+                return dst + g_deltaKing[i];
+            }
+        }
+    }
+
+    return 0;
+}
+
+int SlimBoard::alphabetaWithNegaSearch(int depth, int alpha, int beta, uint16_t* pNextMove)
+{
+    if (depth <= 0 && pNextMove == nullptr) // 叶子节点进入静态搜索，避免水平线效应
+    {
+        return quiescentSearch(alpha, beta);
+    }
+
+    if (distance_ < g_maxPly)
+    {
+        pvLength_[distance_] = static_cast<uint8_t>(distance_);
+    }
+
+    nodes_++;
+    pollLimits();
+
+    if (isStopped()) // 被中止后尽快返回，结果不再使用
+    {
+        return 0;
+    }
+
+    if (winner_ != def::PLAYER_none)
+    {
+        return evaluate(player_); // 评价函数是相对于当前玩家的
+    }
+
+    // 重复局面：已经重复的直接返回；能一步回到之前局面的，至少可以走成和棋
+    if (pNextMove == nullptr)
+    {
+        givesCheck(); // 长将判断需要用到上一步是否将军
+
+        if (int status = detectRepeat(1))
+        {
+            return getRepeatScore(status);
+        }
+
+        if (alpha < g_scoreDraw && hasUpcomingRepeat())
+        {
+            alpha = g_scoreDraw;
+
+            if (alpha >= beta)
+            {
+                return alpha;
+            }
+        }
+    }
+
+    // 杀棋步数裁剪：已经找到更短的杀棋时，此节点不可能再改变结果
+    if (pNextMove == nullptr)
+    {
+        alpha = std::max(alpha, -g_scoreCheckmate + distance_);
+        beta = std::min(beta, g_scoreCheckmate - distance_ - 1);
+
+        if (alpha >= beta)
+        {
+            return alpha;
+        }
+    }
+
+    // 查找置换表，根节点需要返回走法，不能直接截断
+    uint64_t key = zoCurr_.getKey();
+    uint16_t hashMove = 0;
+    TransTable::TEntry entry;
+
+    if (tt_->probe(key, entry))
+    {
+        hashMove = entry.move;
+
+        if (pNextMove == nullptr && entry.depth >= depth)
+        {
+            int score = board::scoreFromTT(entry.score, distance_);
+            TransTable::BOUND_E bound = entry.getBound();
+
+            if ((bound == TransTable::BOUND_exact) ||
+                (bound == TransTable::BOUND_lower && score >= beta) ||
+                (bound == TransTable::BOUND_upper && score <= alpha))
+            {
+                return score;
+            }
+        }
+    }
+
+    // 空着裁剪：让对方连走两步仍然不低于beta，则直接截断
+    // 被将军、上一步是空着、pv节点、没有车马炮时不使用；深度较大时用不走空着的浅层搜索验证，避免被等着局面误导
+    bool pvNode = beta - alpha > 1;
+    bool inCheck = givesCheck();
+    int staticEval = evaluate(player_);
+
+    if (pNextMove == nullptr && !pvNode && !inCheck && depth >= g_nullMinDepth &&
+        (distance_ >= nullMinPly_ || player_ != nullPlayer_) &&
+        !records_.empty() && records_.top().move != 0 &&
+        hasAttackers(player_) && staticEval >= beta)
+    {
+        int reduce = (depth > 6) ? 3 : 2;
+
+        makeNullMove();
+        int val = -alphabetaWithNegaSearch(depth - 1 - reduce, -beta, -beta + 1, nullptr);
+        undoNullMove();
+
+        if (isStopped())
+        {
+            return 0;
+        }
+
+        if (val >= beta)
+        {
+            if (val > g_scoreWin) // 空着得到的杀棋不可靠
+            {
+                val = beta;
+            }
+
+            if (depth < g_nullVerifyDepth)
+            {
+                return val;
+            }
+
+            // 验证搜索，期间当前玩家不能再走空着
+            int nullMinPly = nullMinPly_;
+            def::PLAYER_E nullPlayer = nullPlayer_;
+            nullMinPly_ = distance_ + 3 * (depth - reduce) / 4;
+            nullPlayer_ = player_;
+            int verify = alphabetaWithNegaSearch(depth - reduce, beta - 1, beta, nullptr);
+            nullMinPly_ = nullMinPly;
+            nullPlayer_ = nullPlayer;
+
+            if (verify >= beta)
+            {
+                return val;
+            }
+        }
+    }
+
+    // 剃刀裁剪：局面分远低于alpha，静态搜索也不能超过alpha，则不再展开
+    if (pNextMove == nullptr && !pvNode && !inCheck && depth <= params_.razorMaxDepth &&
+        staticEval + params_.razorMargin * depth < alpha)
+    {
+        int val = quiescentSearch(alpha, beta);
+
+        if (val <= alpha)
+        {
+            return val;
+        }
+    }
+
+    // 前沿节点的无效裁剪：局面分加上余量仍不超过alpha，则不吃子且不将军的走法都不搜索
+    bool futile = pNextMove == nullptr && !pvNode && !inCheck && depth <= params_.futilityMaxDepth &&
+                  staticEval + params_.futilityMargin * depth <= alpha;
+
+    // 内部迭代加深：没有置换表走法时，先用较浅的搜索找出值得最先尝试的走法
+    if (hashMove == 0 && depth >= params_.iidMinDepth && (pvNode || depth >= params_.iidMinDepth + 2))
+    {
+        alphabetaWithNegaSearch(depth - params_.iidReduction, alpha, beta, nullptr);
+
+        if (isStopped())
+        {
+            return 0;
+        }
+
+        if (tt_->probe(key, entry))
+        {
+            hashMove = entry.move;
+        }
+    }
+
+    // 分阶段选择走法：置换表走法、吃子走法、杀手走法，最后才生成按历史分值排序的不吃子走法
+    TMovePicker picker;
+    initPicker(picker, hashMove);
+
+    int maxScore = -g_scoreCheckmate;
+    uint16_t maxMove = 0;
+    int searched = 0;// 已搜索的合法走法数
+    uint16_t quiets[64];// 已搜索的不吃子走法，截断时降低它们的历史分值
+    int quietCount = 0;
+
+    TLegalInfo legalInfo;
+    initLegalInfo(legalInfo);
+
+    while (uint16_t move = nextMove(picker))
+    {
+        if (pNextMove != nullptr && excluded_.contains(move)) // 多主要变例分析时排除前面变例的走法
+        {
+            continue;
+        }
+
+        LEGAL_E legal = isLegalMove(move, legalInfo);
+        if (legal == LEGAL_no)
+        {
+            continue;
+        }
+
+        bool capture = board_[extractDst(move)] != 0;
+        bool lateQuiet = picker.stage == PICK_quiets && !inCheck;// 排在置换表、吃子、杀手走法之后的不吃子走法
+
+        // 无效裁剪在走棋之前判断：已确认合法且不将军的不吃子走法直接跳过，不必走棋再还原
+        if (futile && !capture && move != picker.hashMove && legal == LEGAL_yes && !isCheckingMove(move))
+        {
+            if (staticEval + params_.futilityMargin * depth > maxScore) // 被裁剪走法的分数上界
+            {
+                maxScore = staticEval + params_.futilityMargin * depth;
+            }
+
+            continue;
+        }
+
+        if (doMove(move, legal == LEGAL_yes))
+        {
+            // 将军的走法不减少也不裁剪
+            if ((lateQuiet || (futile && !capture)) && givesCheck())
+            {
+                lateQuiet = false;
+            }
+            else if (futile && !capture && move != picker.hashMove)
+            {
+                undoMove();
+
+                if (staticEval + params_.futilityMargin * depth > maxScore) // 被裁剪走法的分数上界
+                {
+                    maxScore = staticEval + params_.futilityMargin * depth;
+                }
+
+                continue;
+            }
+
+            // 后期走法裁剪：浅层的非pv节点，已搜索足够多的走法后，剩下的不吃子走法不再搜索
+            if (lateQuiet && !pvNode && depth <= params_.lmpMaxDepth &&
+                searched >= params_.lmpBase + depth * depth && maxScore > -g_scoreWin)
+            {
+                undoMove();
+                continue;
+            }
+
+            // 将军延伸：将军的走法不减少深度，每条路线上的延伸层数有上限
+            int extend = (givesCheck() && extensions_ < g_maxExtensions) ? 1 : 0;
+            int newDepth = depth - 1 + extend;
+            extensions_ += extend;
+
+            // 主要变例搜索：第一个走法用完整窗口，其余走法先用零窗口证明不优于当前最佳走法，失败才重新搜索
+            int bestScore = std::max(alpha, maxScore);
+            int val;
+
+            if (searched == 0)
+            {
+                val = -alphabetaWithNegaSearch(newDepth, -beta, -bestScore, nullptr);
+            }
+            else
+            {
+                // 后期走法减少：先用减少后的深度搜索，超过当前最佳分数才恢复深度
+                int reduce = 0;
+
+                if (lateQuiet && depth >= params_.lmrMinDepth && searched >= params_.lmrMinMoves)
+                {
+                    reduce = reductions_[std::min(depth, g_maxDepth)][std::min(searched, MoveList::CAPACITY - 1)];
+                    reduce = std::max(0, std::min(reduce - (pvNode ? 1 : 0), depth - 2));
+                }
+
+                val = -alphabetaWithNegaSearch(newDepth - reduce, -bestScore - 1, -bestScore, nullptr);
+
+                if (reduce > 0 && val > bestScore)
+                {
+                    val = -alphabetaWithNegaSearch(newDepth, -bestScore - 1, -bestScore, nullptr);
+                }
+
+                if (val > bestScore && val < beta)
+                {
+                    val = -alphabetaWithNegaSearch(newDepth, -beta, -bestScore, nullptr);
+                }
+            }
+
+            extensions_ -= extend;
+            undoMove();
+            searched++;
+
+            if (!capture && quietCount < 64)
+            {
+                quiets[quietCount++] = move;
+            }
+
+            if (val > maxScore) // pv走法 beta走法
+            {
+                maxScore = val;
+                maxMove = move;
+
+                if (pvNode && !isStopped())
+                {
+                    updatePV(move);
+                }
+            }
+
+            if (val >= beta) // beta剪枝
+            {
+                cutoffs_++;
+                if (searched == 1)
+                {
+                    firstCutoffs_++;
+                }
+
+                if (!capture)
+                {
+                    updateKillers(move);
+
+                    // 之前搜索过但没有截断的不吃子走法降低历史分值
+                    int bonus = std::min(depth * depth, g_historyBonusMax);
+                    for (int i = 0; i < quietCount - 1; i++)
+                    {
+                        updateHistory(quiets[i], -bonus);
+                    }
+                }
+
+                break;
+            }
         }
     }
 
-    distance_++; // 增加与根节点的距离
+    if (isStopped()) // 中止时子节点的结果不完整，不能保存
+    {
+        return 0;
+    }
+
+    if (maxScore == -g_scoreCheckmate) // 此层无可走的棋，即被将死
+    {
+        maxScore = -g_scoreCheckmate + distance_; // 根据相对于根节点的步数给出评分
+    }
+
+    // 保存到置换表，排除了部分走法的根节点结果不完整，不能保存
+    if (pNextMove == nullptr || excluded_.empty())
+    {
+        TransTable::BOUND_E bound = (maxScore >= beta) ? TransTable::BOUND_lower :
+                                    (maxScore > alpha) ? TransTable::BOUND_exact : TransTable::BOUND_upper;
+        tt_->store(key, maxMove, board::scoreToTT(maxScore, distance_), depth, bound);
+    }
+
+    if (maxMove != 0) // 可以走棋的话，保存该最佳走法
+    {
+        if (board_[extractDst(maxMove)] == 0) // 吃子走法按MVV/LVA排序，不需要历史分值
+        {
+            updateHistory(maxMove, std::min(depth * depth, g_historyBonusMax)); // 层数越深，得分越高
+        }
+
+        if (pNextMove != nullptr)
+        {
+            *pNextMove = maxMove;
+        }
+    }
+
+    return maxScore;
+}
+
+void SlimBoard::initPicker(TMovePicker& picker, uint16_t hashMove)
+{
+    picker.stage = PICK_hash;
+    picker.index = 0;
+    picker.hashMove = hashMove;
+    picker.killers[0] = 0;
+    picker.killers[1] = 0;
+    picker.killers[2] = 0;
+    picker.badCaptures.clear();
+
+    if (distance_ < g_maxPly)
+    {
+        picker.killers[0] = killers_[distance_][0];
+        picker.killers[1] = killers_[distance_][1];
+    }
+
+    if (!records_.empty() && records_.top().move != 0) // 上一步走法的反驳走法
+    {
+        uint8_t dst = extractDst(records_.top().move);
+        picker.killers[2] = counters_[board_[dst]][dst];
+    }
+}
+
+// 依次返回下一个待搜索的走法，返回0表示已取完
+// 置换表走法、杀手走法来自其他局面，需检查是否合法；后续阶段跳过已经返回过的走法
+uint16_t SlimBoard::nextMove(TMovePicker& picker)
+{
+    switch (picker.stage)
+    {
+        case PICK_hash:
+        {
+            picker.stage = PICK_genCaptures;
+
+            if (picker.hashMove != 0 && isValidMove(picker.hashMove))
+            {
+                return picker.hashMove;
+            }
+
+            picker.hashMove = 0;
+        }
+        // fall through
+        case PICK_genCaptures:
+        {
+            generateAllMoves(picker.moves, GEN_capture);
+
+            for (int i = 0; i < picker.moves.size(); i++) // 价值高的被吃子优先，价值低的吃子方优先
+            {
+                uint16_t move = picker.moves.getMove(i);
+                def::PIECE_E victim = def::extractPiece(getIcon(extractDst(move)));
+                def::PIECE_E attacker = def::extractPiece(getIcon(extractSrc(move)));
+                picker.moves.setScore(i, g_mvvLva[victim] * 8 - g_mvvLva[attacker]);
+            }
+
+            picker.index = 0;
+            picker.stage = PICK_captures;
+        }
+        // fall through
+        case PICK_captures:
+        {
+            while (picker.index < picker.moves.size())
+            {
+                picker.moves.pickBest(picker.index);
+                uint16_t move = picker.moves.getMove(picker.index++);
+
+                if (move != picker.hashMove)
+                {
+                    if (isGoodCapture(move))
+                    {
+                        return move;
+                    }
+
+                    picker.badCaptures.push(move);// 亏子的吃子走法推迟到最后
+                }
+            }
+
+            picker.index = 0;
+            picker.stage = PICK_killers;
+        }
+        // fall through
+        case PICK_killers:
+        {
+            while (picker.index < 3)
+            {
+                uint16_t move = picker.killers[picker.index++];
+
+                if (move != 0 && move != picker.hashMove &&
+                    board_[extractDst(move)] == 0 && isValidMove(move) &&
+                    (picker.index != 3 || (move != picker.killers[0] && move != picker.killers[1])))
+                {
+                    return move;
+                }
+            }
+
+            picker.stage = PICK_genQuiets;
+        }
+        // fall through
+        case PICK_genQuiets:
+        {
+            generateAllMoves(picker.moves, GEN_quiet);
+
+            for (int i = 0; i < picker.moves.size(); i++) // 按照历史走法的分值排序
+            {
+                picker.moves.setScore(i, getHistory(picker.moves.getMove(i)));
+            }
+            picker.moves.sort();
+
+            picker.index = 0;
+            picker.stage = PICK_quiets;
+        }
+        // fall through
+        case PICK_quiets:
+        {
+            while (picker.index < picker.moves.size())
+            {
+                uint16_t move = picker.moves.getMove(picker.index++);
+
+                if (move != picker.hashMove && move != picker.killers[0] &&
+                    move != picker.killers[1] && move != picker.killers[2])
+                {
+                    return move;
+                }
+            }
+
+            picker.index = 0;
+            picker.stage = PICK_badCaptures;
+        }
+        // fall through
+        case PICK_badCaptures:
+        {
+            if (picker.index < picker.badCaptures.size())
+            {
+                return picker.badCaptures.getMove(picker.index++);
+            }
+
+            picker.stage = PICK_end;
+        }
+        // fall through
+        default:
+        {
+            return 0;
+        }
+    }
+}
+
+// 不吃子走法产生beta截断时更新杀手走法及反驳走法
+void SlimBoard::updateKillers(uint16_t move)
+{
+    if (distance_ < g_maxPly && killers_[distance_][0] != move)
+    {
+        killers_[distance_][1] = killers_[distance_][0];
+        killers_[distance_][0] = move;
+    }
+
+    if (!records_.empty() && records_.top().move != 0)
+    {
+        uint8_t dst = extractDst(records_.top().move);
+        counters_[board_[dst]][dst] = move;
+    }
+}
+
+// 当前玩家走法的历史分值，red为0，black为1
+int16_t& SlimBoard::getHistory(uint16_t move)
+{
+    return history_[player_ >> 4][move]; // player >> 4  ->  black: 1 red: 0
+}
+
+// 按bonus更新历史分值，分值越接近上限变化越慢，不会溢出
+void SlimBoard::updateHistory(uint16_t move, int bonus)
+{
+    board::updateHistory(getHistory(move), bonus);
+}
+
+// 新一轮搜索前衰减历史分值，保留上一轮搜索的排序信息
+void SlimBoard::ageHistory()
+{
+    for (int i = 0; i < 2; i++)
+    {
+        for (int j = 0; j < 65536; j++)
+        {
+            history_[i][j] /= 2;
+        }
+    }
+}
+
+// 指定走法走棋
+uint8_t SlimBoard::makeMove(def::TMove move)
+{
+    uint8_t srcIdx = toIndex(move.src);
+    uint8_t dstIdx = toIndex(move.dst);
+    uint16_t innerMove = synthesisMove(srcIdx, dstIdx);
+
+    if (!isValidMove(innerMove))
+    {
+        return board::MOVE_RET_invalid;
+    }
+    else
+    {
+        return makeMove(innerMove);
+    }
+}
+
+// 不检查走法是否合法，供UI使用，返回完整的走棋状态
+uint8_t SlimBoard::makeMove(uint16_t move)
+{
+    if (!doMove(move)) // 走棋导致自己被将军，即为自杀
+    {
+        return board::MOVE_RET_suicide;
+    }
+
+    uint8_t ret = board::MOVE_RET_ok;
+
+    if (records_.top().capture != 0)
+    {
+        ret |= board::MOVE_RET_eat;
+    }
+
+    if (givesCheck())
+    {
+        ret |= board::MOVE_RET_check;
+    }
+
+    if (isCheckmate()) // 被将死或困毙都判负
+    {
+        ret |= board::MOVE_RET_dead;
+    }
 
     return ret;
 }
 
+// 搜索内部使用的走棋，只更新棋盘、分数、将的位置和键值
+// 走法导致自杀则还原并返回false，已由isLegalMove确认合法的走法不再检查；是否将军由givesCheck按需计算
+bool SlimBoard::doMove(uint16_t move, bool legal/* = false*/)
+{
+    uint64_t key = zoCurr_.getKey(); // 走棋前局面的键值
+
+    uint8_t capture = movePiece(move); // 走棋
+    if (!legal && isCheck()) // 走棋是否导致自己被将军
+    {
+        undoMovePiece(move, capture);
+        return false;
+    }
+
+    def::switchPlayer(player_); // 切换玩家
+    zoCurr_.Xor(g_zoPlayer);
+    records_.push({move, capture, board::CHECK_unknown, key}); // 保存历史走法
+    repeatCounts_[key & g_repeatMask]++;
+
+    distance_++; // 增加与根节点的距离
+
+    return true;
+}
+
+// 撤销doMove
+void SlimBoard::undoMove()
+{
+    const TRecord& record = records_.top();
+    undoMovePiece(record.move, record.capture);
+    repeatCounts_[record.key & g_repeatMask]--;
+    records_.pop();
+
+    def::switchPlayer(player_);
+    zoCurr_.Xor(g_zoPlayer);
+
+    distance_--;// 减少与根节点的距离
+}
+
+// 空着：不动棋子，只交换走棋方；历史记录中的走法为0，重复局面检测到此为止
+void SlimBoard::makeNullMove()
+{
+    uint64_t key = zoCurr_.getKey();
+
+    def::switchPlayer(player_);
+    zoCurr_.Xor(g_zoPlayer);
+    records_.push({0, 0, board::CHECK_no, key}); // 被将军时不走空着，空着之后对方不会被将军
+    repeatCounts_[key & g_repeatMask]++;
+
+    distance_++;
+}
+
+void SlimBoard::undoNullMove()
+{
+    repeatCounts_[records_.top().key & g_repeatMask]--;
+    records_.pop();
+
+    def::switchPlayer(player_);
+    zoCurr_.Xor(g_zoPlayer);
+
+    distance_--;
+}
+
+// player是否还有车、马、炮，只剩士、象、兵时空着常常对自己有利，不能使用空着裁剪
+bool SlimBoard::hasAttackers(def::PLAYER_E player) const
+{
+    return (player == def::PLAYER_red ? redAttackers_ : blackAttackers_) > 0;
+}
+
+// 上一步走法是否将军，即当前玩家是否被将军，第一次查询时才计算并缓存到历史记录中
+bool SlimBoard::givesCheck()
+{
+    if (records_.empty())
+    {
+        return isCheck();
+    }
+
+    TRecord& record = records_.top();
+    if (record.check == board::CHECK_unknown)
+    {
+        record.check = isCheck() ? board::CHECK_yes : board::CHECK_no;
+    }
+
+    return record.check == board::CHECK_yes;
+}
+
 // 走棋，返回被吃的icon
 uint8_t SlimBoard::movePiece(uint16_t move)
 {
@@ -598,31 +2080,29 @@ void SlimBoard::undoMovePiece(uint16_t move, uint8_t capture)
 }
 
 // 生成当前局面所有合法走法
-void SlimBoard::generateAllMoves(vector<uint16_t>& moves, bool capture/* = false*/) const
+// type为GEN_capture时只生成吃子走法，为GEN_quiet时只生成不吃子走法
+void SlimBoard::generateAllMoves(MoveList& moves, GEN_E type/* = GEN_all*/) const
 {
     moves.clear();
 
-    // for (int src = 0; src < 256; src++)
-    for (int src = 51; src <= 203; src++) // 没必要搜索非法位置
+    int base = getPieceBase(player_);
+
+    for (int i = base; i < base + 16; i++) // 只遍历棋子列表中当前玩家存活的棋子
     {
-        def::ICON_E icon = getIcon(src);
+        uint8_t src = pieces_[i];
 
-        if (def::extractOwner(icon) == player_)
+        if (src != 0)
         {
-            switch (def::extractPiece(icon))
+            switch (def::extractPiece(getIcon(src)))
             {
                 case def::PIECE_king:
                 {
                     for (int i = 0; i < 4; i++)
                     {
                         uint8_t dst = src + g_deltaKing[i];// 将加上偏移量
-                        if (isInSquare(dst))// 在九宫格内
+                        if (isInSquare(dst) && isGenTarget(dst, type))// 在九宫格内
                         {
-                            if ((capture && getOwner(dst) == def::getEnemyPlayer(player_)) ||// 捕获对方棋子
-                                (!capture && getOwner(dst) != player_))// 不捕获的话只要不是己方棋子即可
-                            {
-                                moves.push_back(synthesisMove(src, dst));
-                            }
+                            moves.push(synthesisMove(src, dst));
                         }
                     }
 
@@ -633,13 +2113,9 @@ void SlimBoard::generateAllMoves(vector<uint16_t>& moves, bool capture/* = false
                     for (int i = 0; i < 4; i++)
                     {
                         uint8_t dst = src + g_deltaAdvisor[i];// 将加上偏移量
-                        if (isInSquare(dst))// 在九宫格内
+                        if (isInSquare(dst) && isGenTarget(dst, type))// 在九宫格内
                         {
-                            if ((capture && getOwner(dst) == def::getEnemyPlayer(player_)) ||// 捕获对方棋子
-                                (!capture && getOwner(dst) != player_))// 不捕获的话只要不是己方棋子即可
-                            {
-                                moves.push_back(synthesisMove(src, dst));
-                            }
+                            moves.push(synthesisMove(src, dst));
                         }
                     }
 
@@ -653,10 +2129,9 @@ void SlimBoard::generateAllMoves(vector<uint16_t>& moves, bool capture/* = false
                         if (isInBoard(dst) && isHomeHalf(dst, player_) && board_[dst] == 0)// 象眼位置为空
                         {
                             dst += g_deltaAdvisor[i];// 得到象位置
-                            if ((capture && getOwner(dst) == def::getEnemyPlayer(player_)) ||// 捕获对方棋子
-                                (!capture && getOwner(dst) != player_))// 不捕获的话只要不是己方棋子即可
+                            if (isGenTarget(dst, type))
                             {
-                                moves.push_back(synthesisMove(src, dst));
+                                moves.push(synthesisMove(src, dst));
                             }
                         }
                     }
@@ -673,106 +2148,32 @@ void SlimBoard::generateAllMoves(vector<uint16_t>& moves, bool capture/* = false
                             for (int j = 0; j < 2; j++)
                             {
                                 dst = src + g_deltaKnight[i][j];// 得到马位置
-                                if (isInBoard(dst))
-                                {
-                                    if ((capture && getOwner(dst) == def::getEnemyPlayer(player_)) ||// 捕获对方棋子
-                                        (!capture && getOwner(dst) != player_))// 不捕获的话只要不是己方棋子即可
-                                    {
-                                        moves.push_back(synthesisMove(src, dst));
-                                    }
-                                }
-                            }
-                        }
-                    }
-
-                    break;
-                }
-                case def::PIECE_rook:
-                {
-                    for (int i = 0; i < 4; i++)
-                    {
-                        int8_t delta = g_deltaKing[i];
-                        uint8_t dst = src + delta;
-
-                        while (isInBoard(dst))
-                        {
-                            if (board_[dst] == 0)// 空
-                            {
-                                if (!capture)// 不捕获棋子才能添加
+                                if (isInBoard(dst) && isGenTarget(dst, type))
                                 {
-                                    moves.push_back(synthesisMove(src, dst));
+                                    moves.push(synthesisMove(src, dst));
                                 }
                             }
-                            else// 非空的话，捕获或者不捕获均可添加
-                            {
-                                if (getOwner(dst) != player_)// 非空则停止当前循环
-                                {
-                                    moves.push_back(synthesisMove(src, dst));
-                                }
-
-                                break;
-                            }
-
-                            dst += delta;
                         }
                     }
 
                     break;
-                }
-                case def::PIECE_cannon:
-                {
-                    for (int i = 0; i < 4; i++)
-                    {
-                        int8_t delta = g_deltaKing[i];
-                        uint8_t dst = src + delta;
-
-                        while (isInBoard(dst))
-                        {
-                            if (board_[dst] == 0)
-                            {
-                                if (!capture)// 不捕获棋子才能添加
-                                {
-                                    moves.push_back(synthesisMove(src, dst));// 无炮架可直接移动到空位置
-                                    dst += delta;
-                                }
-                            }
-                            else
-                            {
-                                break;
-                            }
-                        }
-
-                        dst += delta;// 跳过炮架
-                        while (isInBoard(dst))
-                        {
-                            if (board_[dst] == 0)// 跳过空格
-                            {
-                                dst += delta;
-                            }
-                            else// 非空的话，捕获或者不捕获均可添加
-                            {
-                                if (getOwner(dst) != player_)// 非己方棋子
-                                {
-                                    moves.push_back(synthesisMove(src, dst));
-                                }
-
-                                break;// 一旦搜索到非空棋子即可停止搜索
-                            }
-                        }
-                    }
-
+                }
+                case def::PIECE_rook:
+                {
+                    generateSlides(moves, src, false, type);
+                    break;
+                }
+                case def::PIECE_cannon:
+                {
+                    generateSlides(moves, src, true, type);
                     break;
                 }
                 case def::PIECE_pawn:
                 {
                     uint8_t dst = getPawnForwardIndex(src, player_);
-                    if (isInBoard(dst))// 先向前移动
+                    if (isInBoard(dst) && isGenTarget(dst, type))// 先向前移动
                     {
-                        if ((capture && getOwner(dst) == def::getEnemyPlayer(player_)) ||// 捕获对方棋子
-                            (!capture && getOwner(dst) != player_))// 不捕获的话只要不是己方棋子即可
-                        {
-                            moves.push_back(synthesisMove(src, dst));
-                        }
+                        moves.push(synthesisMove(src, dst));
                     }
 
                     if (isAnotherHalf(src, player_))// 过河后才可左右移动
@@ -780,13 +2181,9 @@ void SlimBoard::generateAllMoves(vector<uint16_t>& moves, bool capture/* = false
                         for (int i = -1; i <= 1; i += 2)
                         {
                             dst = src + i;
-                            if (isInBoard(dst))// 左右移动
+                            if (isInBoard(dst) && isGenTarget(dst, type))// 左右移动
                             {
-                                if ((capture && getOwner(dst) == def::getEnemyPlayer(player_)) ||// 捕获对方棋子
-                                    (!capture && getOwner(dst) != player_))// 不捕获的话只要不是己方棋子即可
-                                {
-                                    moves.push_back(synthesisMove(src, dst));
-                                }
+                                moves.push(synthesisMove(src, dst));
                             }
                         }
                     }
@@ -802,6 +2199,241 @@ void SlimBoard::generateAllMoves(vector<uint16_t>& moves, bool capture/* = false
     }
 }
 
+// 车、炮的走法：以所在行、列的占用位查表，一次得到不吃子的空位和吃子的目标
+void SlimBoard::generateSlides(MoveList& moves, uint8_t src, bool cannon, GEN_E type) const
+{
+    int row = (src >> 4) - 3;
+    int col = (src & 15) - 3;
+    const board::TSlide& rank = board::g_rankSlides[col][rankOcc_[row]];
+    const board::TSlide& file = board::g_fileSlides[row][fileOcc_[col]];
+
+    if (type != GEN_quiet)
+    {
+        uint32_t bits = cannon ? rank.cannonCapture : rank.rookCapture;
+        for (; bits != 0; bits &= bits - 1)
+        {
+            uint8_t dst = src + board::getFirstBit(bits) - col;
+            if (getOwner(dst) != player_)// 非己方棋子
+            {
+                moves.push(synthesisMove(src, dst));
+            }
+        }
+
+        bits = cannon ? file.cannonCapture : file.rookCapture;
+        for (; bits != 0; bits &= bits - 1)
+        {
+            uint8_t dst = src + (board::getFirstBit(bits) - row) * 16;
+            if (getOwner(dst) != player_)
+            {
+                moves.push(synthesisMove(src, dst));
+            }
+        }
+    }
+
+    if (type != GEN_capture)
+    {
+        for (uint32_t bits = rank.quiet; bits != 0; bits &= bits - 1)
+        {
+            moves.push(synthesisMove(src, src + board::getFirstBit(bits) - col));
+        }
+
+        for (uint32_t bits = file.quiet; bits != 0; bits &= bits - 1)
+        {
+            moves.push(synthesisMove(src, src + (board::getFirstBit(bits) - row) * 16));
+        }
+    }
+}
+
+// 生成当前局面的合法走法，无法直接判断的走法走棋后检查是否被将军
+void SlimBoard::generateLegalMoves(MoveList& moves, GEN_E type/* = GEN_all*/)
+{
+    MoveList all;
+    generateAllMoves(all, type);
+
+    TLegalInfo info;
+    initLegalInfo(info);
+
+    moves.clear();
+    for (uint16_t move: all)
+    {
+        LEGAL_E legal = isLegalMove(move, info);
+
+        if (legal == LEGAL_unknown)
+        {
+            uint8_t capture = movePiece(move);
+            legal = isCheck() ? LEGAL_no : LEGAL_yes;
+            undoMovePiece(move, capture);
+        }
+
+        if (legal == LEGAL_yes)
+        {
+            moves.push(move);
+        }
+    }
+}
+
+// 计算当前玩家的将受到的牵制：沿将所在行、列向四个方向取最近的三个棋子，
+// 第二个是对方的车(列上还有对方的将)时第一个被牵制，第三个是对方的炮时前两个都被牵制，
+// 第一个是对方的炮时两者之间的空位都不能走入；挡住对方马腿的己方棋子也被牵制
+void SlimBoard::initLegalInfo(TLegalInfo& info)
+{
+    uint8_t kingIdx = findKing(player_);
+    def::PLAYER_E enemyPlayer = def::getEnemyPlayer(player_);
+
+    info.inCheck = givesCheck();
+    info.kingIdx = kingIdx;
+    info.pinnedNum = 0;
+    info.screens[0] = 0;
+    info.screens[1] = 0;
+
+    if (kingIdx == 0)
+    {
+        return;
+    }
+
+    uint8_t enemyKing   = def::synthesisIcon(enemyPlayer, def::PIECE_king);
+    uint8_t enemyKnight = def::synthesisIcon(enemyPlayer, def::PIECE_knight);
+    uint8_t enemyRook   = def::synthesisIcon(enemyPlayer, def::PIECE_rook);
+    uint8_t enemyCannon = def::synthesisIcon(enemyPlayer, def::PIECE_cannon);
+    int row = (kingIdx >> 4) - 3;
+    int col = (kingIdx & 15) - 3;
+
+    for (int i = 0; i < 4; i++) // 0、1为行上的左、右，2、3为列上的上、下
+    {
+        int line = i >> 1;
+        int pos = (line == 0) ? col : row;
+        int step = (line == 0) ? 1 : 16;
+        uint32_t occ = (line == 0) ? rankOcc_[row] : fileOcc_[col];
+        uint32_t bits = (i & 1) ? (occ & ~((2u << pos) - 1)) : (occ & ((1u << pos) - 1));
+
+        int near[3] = {-1, -1, -1}; // 由近到远的三个棋子在该行(列)上的位置
+        for (int j = 0; j < 3 && bits != 0; j++)
+        {
+            near[j] = (i & 1) ? board::getFirstBit(bits) : board::getLastBit(bits);
+            bits ^= 1u << near[j];
+        }
+
+        if (near[0] < 0)
+        {
+            continue;
+        }
+
+        uint8_t first = kingIdx + (near[0] - pos) * step;
+        if (board_[first] == enemyCannon)
+        {
+            int lo = std::min(pos, near[0]);
+            int hi = std::max(pos, near[0]);
+            info.screens[line] |= (1u << hi) - (2u << lo);
+        }
+
+        if (near[1] < 0)
+        {
+            continue;
+        }
+
+        uint8_t second = kingIdx + (near[1] - pos) * step;
+        if (board_[second] == enemyRook || board_[second] == enemyKing)
+        {
+            if (getOwner(first) == player_)
+            {
+                info.pinned[info.pinnedNum++] = first;
+            }
+        }
+        else if (near[2] >= 0 && board_[kingIdx + (near[2] - pos) * step] == enemyCannon)
+        {
+            if (getOwner(first) == player_)
+            {
+                info.pinned[info.pinnedNum++] = first;
+            }
+
+            if (getOwner(second) == player_)
+            {
+                info.pinned[info.pinnedNum++] = second;
+            }
+        }
+    }
+
+    for (int i = 0; i < 4; i++)
+    {
+        uint8_t leg = kingIdx + g_deltaAdvisor[i];
+        if (getOwner(leg) == player_ &&
+            (board_[kingIdx + g_deltaKnightCheck[i][0]] == enemyKnight || board_[kingIdx + g_deltaKnightCheck[i][1]] == enemyKnight))
+        {
+            info.pinned[info.pinnedNum++] = leg;
+        }
+    }
+}
+
+// 伪合法走法是否合法：将的走法拿走将后查目标位置是否被攻击；被将军或走动被牵制的棋子时返回LEGAL_unknown；
+// 其余走法只有走入将与对方炮之间才会被将军
+SlimBoard::LEGAL_E SlimBoard::isLegalMove(uint16_t move, const TLegalInfo& info)
+{
+    uint8_t src = extractSrc(move);
+    uint8_t dst = extractDst(move);
+
+    if (src == info.kingIdx)
+    {
+        def::PLAYER_E enemyPlayer = def::getEnemyPlayer(player_);
+        uint8_t enemyKingIdx = findKing(enemyPlayer);
+        uint8_t king = board_[src];
+
+        board_[src] = 0;
+        flipOccupancy(src);
+
+        bool attacked = getLeastAttacker(dst, enemyPlayer) != 0;
+        if (!attacked && isSameCol(dst, enemyKingIdx)) // 将帅对脸
+        {
+            int row = (dst >> 4) - 3;
+            int col = (dst & 15) - 3;
+            attacked = (board::g_fileSlides[row][fileOcc_[col]].rookCapture & (1 << ((enemyKingIdx >> 4) - 3))) != 0;
+        }
+
+        board_[src] = king;
+        flipOccupancy(src);
+
+        return attacked ? LEGAL_no : LEGAL_yes;
+    }
+
+    if (info.inCheck)
+    {
+        return LEGAL_unknown;
+    }
+
+    for (int i = 0; i < info.pinnedNum; i++)
+    {
+        if (info.pinned[i] == src)
+        {
+            return LEGAL_unknown;
+        }
+    }
+
+    if (isSameRow(dst, info.kingIdx) && (info.screens[0] & (1 << ((dst & 15) - 3))) != 0)
+    {
+        return LEGAL_no;
+    }
+
+    if (isSameCol(dst, info.kingIdx) && (info.screens[1] & (1 << ((dst >> 4) - 3))) != 0)
+    {
+        return LEGAL_no;
+    }
+
+    return LEGAL_yes;
+}
+
+// dst是否可作为type类型走法的终点
+bool SlimBoard::isGenTarget(uint8_t dst, GEN_E type) const
+{
+    switch (type)
+    {
+        case GEN_capture:
+            return getOwner(dst) == def::getEnemyPlayer(player_);// 捕获对方棋子
+        case GEN_quiet:
+            return board_[dst] == 0;// 只走到空位置
+        default:
+            return getOwner(dst) != player_;// 只要不是己方棋子即可
+    }
+}
+
 // 获取当前局面下的玩家分数
 int SlimBoard::getScore(def::PLAYER_E player) const
 {
@@ -858,12 +2490,49 @@ bool SlimBoard::isCheck()
 {
     // 此处的kingIdx是当前玩家的将的坐标
     uint8_t kingIdx = ((getNextPlayer() == def::PLAYER_black) ? blackKingIdx_ : redKingIdx_);
-    // 此处的enemyPlayer是更新next_player之后的玩家
-    def::PLAYER_E enemyPlayer = def::getEnemyPlayer(getNextPlayer());
+
+    return isKingAttacked(kingIdx, getNextPlayer());
+}
+
+// 走法走棋后是否将军对方，只临时改动棋盘和占用位，不必完整地走棋和还原
+bool SlimBoard::isCheckingMove(uint16_t move)
+{
+    uint8_t srcIdx = extractSrc(move);
+    uint8_t dstIdx = extractDst(move);
+    uint8_t srcIcon = board_[srcIdx];
+    uint8_t dstIcon = board_[dstIdx];
+    def::PLAYER_E enemyPlayer = def::getEnemyPlayer(player_);
+    uint8_t enemyKingIdx = (enemyPlayer == def::PLAYER_black) ? blackKingIdx_ : redKingIdx_;
+
+    board_[srcIdx] = 0;
+    board_[dstIdx] = srcIcon;
+    flipOccupancy(srcIdx);
+    if (dstIcon == 0)
+    {
+        flipOccupancy(dstIdx);
+    }
+
+    bool check = isKingAttacked(enemyKingIdx, enemyPlayer);
+
+    board_[srcIdx] = srcIcon;
+    board_[dstIdx] = dstIcon;
+    flipOccupancy(srcIdx);
+    if (dstIcon == 0)
+    {
+        flipOccupancy(dstIdx);
+    }
+
+    return check;
+}
+
+// player方kingIdx上的将是否被对方攻击
+bool SlimBoard::isKingAttacked(uint8_t kingIdx, def::PLAYER_E player) const
+{
+    def::PLAYER_E enemyPlayer = def::getEnemyPlayer(player);
 
     // 把将当作卒，如果能吃到对方的卒，即被对方的卒将军
     def::ICON_E enemyPawn = def::synthesisIcon(enemyPlayer, def::PIECE_pawn);
-    if (board_[getPawnForwardIndex(kingIdx, player_)] == enemyPawn ||
+    if (board_[getPawnForwardIndex(kingIdx, player)] == enemyPawn ||
         board_[kingIdx - 1] == enemyPawn ||
         board_[kingIdx + 1] == enemyPawn)
     {
@@ -872,14 +2541,13 @@ bool SlimBoard::isCheck()
 
     // 把将当作马，如果能吃到对方的马，即被对方的马将军
     def::ICON_E enemyKnight = def::synthesisIcon(enemyPlayer, def::PIECE_knight);
-    static const int8_t knightCheckDelta[4][2] = {{-33, -18}, {-31, -14}, {14, 31}, {18, 33}};// 此处的马腿不使用正常的位置，以士的偏移位置作为马腿
     for (int i = 0; i < 4; i++)
     {
         if (board_[kingIdx + g_deltaAdvisor[i]] == 0)// 马腿位置为空才继续判断
         {
             for (int j = 0; j < 2; j++)
             {
-                if (getIcon(kingIdx + knightCheckDelta[i][j]) == enemyKnight)// 有对方马，即被将军
+                if (getIcon(kingIdx + g_deltaKnightCheck[i][j]) == enemyKnight)// 有对方马，即被将军
                 {
                     return true;
                 }
@@ -887,76 +2555,58 @@ bool SlimBoard::isCheck()
         }
     }
 
-    // 向将的四个方向延伸，判断是否被车/炮将军，或者将帅对脸
+    // 查将所在行、列的占用表，判断是否被车/炮将军，或者将帅对脸(双方的将不会在同一行)
     def::ICON_E enemyKing   = def::synthesisIcon(enemyPlayer, def::PIECE_king);
     def::ICON_E enemyRook   = def::synthesisIcon(enemyPlayer, def::PIECE_rook);
     def::ICON_E enemyCannon = def::synthesisIcon(enemyPlayer, def::PIECE_cannon);
-    for (int i = 0; i < 4; i++)
-    {
-        int8_t delta = g_deltaKing[i];
-        uint8_t cur = kingIdx + delta;
+    int row = (kingIdx >> 4) - 3;
+    int col = (kingIdx & 15) - 3;
+    const board::TSlide& rank = board::g_rankSlides[col][rankOcc_[row]];
+    const board::TSlide& file = board::g_fileSlides[row][fileOcc_[col]];
 
-        while (isInBoard(cur)) // 先找到第一个非空棋子
+    for (uint32_t bits = rank.rookCapture; bits != 0; bits &= bits - 1)
+    {
+        if (board_[kingIdx + board::getFirstBit(bits) - col] == enemyRook)
         {
-            if (board_[cur] != 0)
-            {
-                if (board_[cur] == enemyRook || board_[cur] == enemyKing)
-                {
-                    return true;
-                }
-                else
-                {
-                    break;
-                }
-            }
+            return true;
+        }
+    }
 
-            cur += delta;
+    for (uint32_t bits = file.rookCapture; bits != 0; bits &= bits - 1)
+    {
+        uint8_t icon = board_[kingIdx + (board::getFirstBit(bits) - row) * 16];
+        if (icon == enemyRook || icon == enemyKing)
+        {
+            return true;
         }
+    }
 
-        cur += delta;
-        while (isInBoard(cur)) // 若能继续往前找到对方的炮，即被对方的炮将死
+    for (uint32_t bits = rank.cannonCapture; bits != 0; bits &= bits - 1) // 隔一个棋子的是对方的炮
+    {
+        if (board_[kingIdx + board::getFirstBit(bits) - col] == enemyCannon)
         {
-            if (board_[cur] != 0)
-            {
-                if (board_[cur] == enemyCannon)
-                {
-                    return true;
-                }
-                else
-                {
-                    break;
-                }
-            }
+            return true;
+        }
+    }
 
-            cur += delta;
+    for (uint32_t bits = file.cannonCapture; bits != 0; bits &= bits - 1)
+    {
+        if (board_[kingIdx + (board::getFirstBit(bits) - row) * 16] == enemyCannon)
+        {
+            return true;
         }
     }
 
     return false;
 }
 
-// 判断当前是否将死
+// 判断当前玩家是否没有合法走法，被将死或困毙
 bool SlimBoard::isCheckmate()
 {
-    vector<uint16_t> moves;
-    generateAllMoves(moves); // 生成当前所有合法走法
-
-    for (uint16_t move: moves)
-    {
-        uint8_t capture = movePiece(move); // 尝试走棋
-
-        if (!isCheck()) // 可应将，即可停止搜索
-        {
-            undoMovePiece(move, capture); // 还原
-            return false;
-        }
-        else
-        {
-            undoMovePiece(move, capture); // 还原
-        }
-    }
+    MoveList moves;
+    generateLegalMoves(moves);
 
-    return true;
+    return moves.empty();
 }
 
 // 上下翻转后的一维坐标
@@ -998,136 +2648,6 @@ bool SlimBoard::isInSquare(uint8_t idx) const
 // 获取idx位置处棋子的子力价值
 uint8_t SlimBoard::getValue(def::ICON_E icon, uint8_t idx) const
 {
-    static const uint8_t redValue[7][256] =
-    {
-        { // king
-            0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
-            0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
-            0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
-            0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
-            0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
-            0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
-            0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
-            0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
-            0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
-            0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
-            0,  0,  0,  0,  0,  0,  1,  1,  1,  0,  0,  0,  0,  0,  0,  0,
-            0,  0,  0,  0,  0,  0,  2,  2,  2,  0,  0,  0,  0,  0,  0,  0,
-            0,  0,  0,  0,  0,  0, 11, 15, 11,  0,  0,  0,  0,  0,  0,  0,
-            0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
-            0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
-            0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0
-        },
-        { // advisor
-            0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
-            0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
-            0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
-            0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
-            0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
-            0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
-            0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
-            0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
-            0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
-            0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
-            0,  0,  0,  0,  0,  0, 20,  0, 20,  0,  0,  0,  0,  0,  0,  0,
-            0,  0,  0,  0,  0,  0,  0, 23,  0,  0,  0,  0,  0,  0,  0,  0,
-            0,  0,  0,  0,  0,  0, 20,  0, 20,  0,  0,  0,  0,  0,  0,  0,
-            0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
-            0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
-            0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0
-        },
-        { // bishop
-            0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
-            0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
-            0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
-            0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
-            0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
-            0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
-            0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
-            0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
-            0,  0,  0,  0,  0, 20,  0,  0,  0, 20,  0,  0,  0,  0,  0,  0,
-            0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
-            0,  0,  0, 18,  0,  0,  0, 23,  0,  0,  0, 18,  0,  0,  0,  0,
-            0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
-            0,  0,  0,  0,  0, 20,  0,  0,  0, 20,  0,  0,  0,  0,  0,  0,
-            0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
-            0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
-            0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0
-        },
-        { // knight
-            0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
-            0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
-            0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
-            0,  0,  0, 90, 90, 90, 96, 90, 96, 90, 90, 90,  0,  0,  0,  0,
-            0,  0,  0, 90, 96,103, 97, 94, 97,103, 96, 90,  0,  0,  0,  0,
-            0,  0,  0, 92, 98, 99,103, 99,103, 99, 98, 92,  0,  0,  0,  0,
-            0,  0,  0, 93,108,100,107,100,107,100,108, 93,  0,  0,  0,  0,
-            0,  0,  0, 90,100, 99,103,104,103, 99,100, 90,  0,  0,  0,  0,
-            0,  0,  0, 90, 98,101,102,103,102,101, 98, 90,  0,  0,  0,  0,
-            0,  0,  0, 92, 94, 98, 95, 98, 95, 98, 94, 92,  0,  0,  0,  0,
-            0,  0,  0, 93, 92, 94, 95, 92, 95, 94, 92, 93,  0,  0,  0,  0,
-            0,  0,  0, 85, 90, 92, 93, 78, 93, 92, 90, 85,  0,  0,  0,  0,
-            0,  0,  0, 88, 85, 90, 88, 90, 88, 90, 85, 88,  0,  0,  0,  0,
-            0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
-            0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
-            0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0
-        },
-        { // rook
-            0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
-            0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
-            0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
-            0,  0,  0,206,208,207,213,214,213,207,208,206,  0,  0,  0,  0,
-            0,  0,  0,206,212,209,216,233,216,209,212,206,  0,  0,  0,  0,
-            0,  0,  0,206,208,207,214,216,214,207,208,206,  0,  0,  0,  0,
-            0,  0,  0,206,213,213,216,216,216,213,213,206,  0,  0,  0,  0,
-            0,  0,  0,208,211,211,214,215,214,211,211,208,  0,  0,  0,  0,
-            0,  0,  0,208,212,212,214,215,214,212,212,208,  0,  0,  0,  0,
-            0,  0,  0,204,209,204,212,214,212,204,209,204,  0,  0,  0,  0,
-            0,  0,  0,198,208,204,212,212,212,204,208,198,  0,  0,  0,  0,
-            0,  0,  0,200,208,206,212,200,212,206,208,200,  0,  0,  0,  0,
-            0,  0,  0,194,206,204,212,200,212,204,206,194,  0,  0,  0,  0,
-            0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
-            0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
-            0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0
-        },
-        { // cannon
-            0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
-            0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
-            0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
-            0,  0,  0,100,100, 96, 91, 90, 91, 96,100,100,  0,  0,  0,  0,
-            0,  0,  0, 98, 98, 96, 92, 89, 92, 96, 98, 98,  0,  0,  0,  0,
-            0,  0,  0, 97, 97, 96, 91, 92, 91, 96, 97, 97,  0,  0,  0,  0,
-            0,  0,  0, 96, 99, 99, 98,100, 98, 99, 99, 96,  0,  0,  0,  0,
-            0,  0,  0, 96, 96, 96, 96,100, 96, 96, 96, 96,  0,  0,  0,  0,
-            0,  0,  0, 95, 96, 99, 96,100, 96, 99, 96, 95,  0,  0,  0,  0,
-            0,  0,  0, 96, 96, 96, 96, 96, 96, 96, 96, 96,  0,  0,  0,  0,
-            0,  0,  0, 97, 96,100, 99,101, 99,100, 96, 97,  0,  0,  0,  0,
-            0,  0,  0, 96, 97, 98, 98, 98, 98, 98, 97, 96,  0,  0,  0,  0,
-            0,  0,  0, 96, 96, 97, 99, 99, 99, 97, 96, 96,  0,  0,  0,  0,
-            0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
-            0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
-            0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0
-        },
-        { // pawn
-            0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
-            0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
-            0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
-            0,  0,  0,  9,  9,  9, 11, 13, 11,  9,  9,  9,  0,  0,  0,  0,
-            0,  0,  0, 19, 24, 34, 42, 44, 42, 34, 24, 19,  0,  0,  0,  0,
-            0,  0,  0, 19, 24, 32, 37, 37, 37, 32, 24, 19,  0,  0,  0,  0,
-            0,  0,  0, 19, 23, 27, 29, 30, 29, 27, 23, 19,  0,  0,  0,  0,
-            0,  0,  0, 14, 18, 20, 27, 29, 27, 20, 18, 14,  0,  0,  0,  0,
-            0,  0,  0,  7,  0, 13,  0, 16,  0, 13,  0,  7,  0,  0,  0,  0,
-            0,  0,  0,  7,  0,  7,  0, 15,  0,  7,  0,  7,  0,  0,  0,  0,
-            0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
-            0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
-            0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
-            0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
-            0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
-            0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0
-        }
-    };
-
     def::PLAYER_E owner = def::extractOwner(icon);
     def::PIECE_E  piece = def::extractPiece(icon);
     // 异常情况直接返回0
@@ -1141,7 +2661,7 @@ uint8_t SlimBoard::getValue(def::ICON_E icon, uint8_t idx) const
         idx = getRotateIndex(idx); // 黑方要翻转pos坐标
     }
 
-    return redValue[piece - 1][idx]; // 棋子值要减一才能作为下表使用
+    return board::g_redValue[piece - 1][idx]; // 棋子值要减一才能作为下表使用
 }
 
 // 将一维坐标转换为二维坐标
@@ -1150,6 +2670,17 @@ def::TPos SlimBoard::toPos(uint8_t idx) const
     return {(idx >> 4) - 3, (idx & 15) - 3}; // 减去边缘的3
 }
 
+// 将内部走法转换为二维坐标的走法
+def::TMove SlimBoard::toMove(uint16_t move) const
+{
+    return {toPos(extractSrc(move)), toPos(extractDst(move))};
+}
+
+uint64_t SlimBoard::getKey() const
+{
+    return zoCurr_.getKey();
+}
+
 // 将二维坐标转换为一维坐标
 uint8_t SlimBoard::toIndex(def::TPos pos) const
 {
@@ -1264,7 +2795,7 @@ def::ICON_E SlimBoard::getIcon(uint8_t idx) const
 // 查找一维坐标idx位置的icon的所属玩家
 def::PLAYER_E SlimBoard::getOwner(uint8_t idx) const
 {
-    return def::extractOwner(getIcon(idx));
+    return static_cast<def::PLAYER_E>(board_[idx] & def::PLAYER_MASK);
 }
 
 // 是否是合法走法
@@ -1487,22 +3018,34 @@ void SlimBoard::addIcon(uint8_t idx, def::ICON_E icon)
     if (owner == def::PLAYER_red)// 增加对应玩家分数
     {
         redScore_ += value;
-        zoCurr_.Xor(g_zoTable[value - 9][idx]);// 更新zorbris
+        zoCurr_.Xor(getZobrist(icon, idx));// 更新zorbris
         // 更新将的坐标
         if (piece == def::PIECE_king)
         {
             redKingIdx_ = idx;
         }
+        else if (piece == def::PIECE_rook || piece == def::PIECE_knight || piece == def::PIECE_cannon)
+        {
+            redAttackers_++;
+        }
+
+        addPiece(idx, icon);
     }
     else if (owner == def::PLAYER_black)
     {
         blackScore_ += value;
-        zoCurr_.Xor(g_zoTable[value - 10][idx]);// 更新zorbris
+        zoCurr_.Xor(getZobrist(icon, idx));// 更新zorbris
         // 更新将的坐标
         if (piece == def::PIECE_king)
         {
             blackKingIdx_ = idx;
         }
+        else if (piece == def::PIECE_rook || piece == def::PIECE_knight || piece == def::PIECE_cannon)
+        {
+            blackAttackers_++;
+        }
+
+        addPiece(idx, icon);
     }
 }
 
@@ -1510,114 +3053,174 @@ void SlimBoard::addIcon(uint8_t idx, def::ICON_E icon)
 void SlimBoard::delIcon(uint8_t idx, def::ICON_E icon)
 {
     board_[idx] = def::ICON_empty;// 删除棋子
+    delPiece(idx);
     
     int value = getValue(icon, idx);
-    int owner = getOwner(idx);
+    int owner = def::extractOwner(icon);// 注意：此时board_[idx]已清空，只能从icon中提取
     int piece = def::extractPiece(icon);
 
     if (owner == def::PLAYER_red)// 减少对应玩家分数
     {
         redScore_ -= value; // 更新分数
-        zoCurr_.Xor(g_zoTable[value - 9][idx]); // 更新zorbris
+        zoCurr_.Xor(getZobrist(icon, idx)); // 更新zorbris
         // 更新将的坐标
         if (piece == def::PIECE_king)
         {
             redKingIdx_ = 0;
         }
+        else if (piece == def::PIECE_rook || piece == def::PIECE_knight || piece == def::PIECE_cannon)
+        {
+            redAttackers_--;
+        }
     }
     else if (owner == def::PLAYER_black)
     {
         blackScore_ -= value; // 更新分数
-        zoCurr_.Xor(g_zoTable[value - 10][idx]); // 更新zorbris
+        zoCurr_.Xor(getZobrist(icon, idx)); // 更新zorbris
         // 更新将的坐标
         if (piece == def::PIECE_king)
         {
             blackKingIdx_ = 0;
         }
+        else if (piece == def::PIECE_rook || piece == def::PIECE_knight || piece == def::PIECE_cannon)
+        {
+            blackAttackers_--;
+        }
     }
 }
 
 // 查找player的将的坐标
 uint8_t SlimBoard::findKing(def::PLAYER_E player) const
 {
-    def::ICON_E king = def::synthesisIcon(player, def::PIECE_king);
+    return pieces_[getPieceBase(player)]; // 将占用序号范围的第一个
+}
 
-    for (int i = 0; i < 256; i++)
+// 在该类棋子的序号范围内取第一个空位
+void SlimBoard::addPiece(uint8_t idx, def::ICON_E icon)
+{
+    int base = getPieceBase(def::extractOwner(icon));
+    const uint8_t* range = g_pieceSlots[def::extractPiece(icon)];
+
+    for (int i = base + range[0]; i < base + range[1]; i++)
     {
-        if (getIcon(i) == king)
+        if (pieces_[i] == 0)
         {
-            return i;
+            pieces_[i] = idx;
+            pieceSlots_[idx] = static_cast<uint8_t>(i);
+            flipOccupancy(idx);
+            return;
         }
     }
 
-    return 0;
+    assert(false); // 同类棋子超过规定数量
+}
+
+void SlimBoard::delPiece(uint8_t idx)
+{
+    if (pieceSlots_[idx] != 0)
+    {
+        pieces_[pieceSlots_[idx]] = 0;
+        pieceSlots_[idx] = 0;
+        flipOccupancy(idx);
+    }
+}
+
+void SlimBoard::flipOccupancy(uint8_t idx)
+{
+    int row = (idx >> 4) - 3; // 减去边缘的3
+    int col = (idx & 15) - 3;
+
+    rankOcc_[row] ^= 1 << col;
+    fileOcc_[col] ^= 1 << row;
+}
+
+// 根据棋盘建立棋子列表及行、列占用位
+void SlimBoard::initPieces()
+{
+    memset(pieces_, 0, sizeof(pieces_));
+    memset(pieceSlots_, 0, sizeof(pieceSlots_));
+    memset(rankOcc_, 0, sizeof(rankOcc_));
+    memset(fileOcc_, 0, sizeof(fileOcc_));
+
+    for (int i = 51; i <= 203; i++)
+    {
+        if (getOwner(i) != def::PLAYER_none)
+        {
+            addPiece(i, getIcon(i));
+        }
+    }
 }
 
-/*
-    A. 返回0，表示没有重复局面；
-    B. 返回1，表示存在重复局面，但双方都无长将(判和)；
-    C. 返回3(=1+2)，表示存在重复局面，本方单方面长将(判本方负)；
-    D. 返回5(=1+4)，表示存在重复局面，对方单方面长将(判对方负)；
-    E. 返回7(=1+2+4)，表示存在重复局面，双方长将(判和)。
-*/
+// 返回值见board::detectRepeat，先查计数表排除大多数不可能重复的局面
 int SlimBoard::detectRepeat(int count)
 {
-    def::PLAYER_E player = def::getEnemyPlayer(player_); // 上一玩家
-    bool selfPerpetualCheck = false;
-    bool ememyPerpetualCheck = false;
+    uint64_t key = zoCurr_.getKey();
+    if (repeatCounts_[key & g_repeatMask] == 0) // 历史记录中没有低位相同的键值，不可能重复
+    {
+        return 0;
+    }
+
+    return board::detectRepeat(records_, key, count);
+}
+
+// 即将重复：当前玩家走一步可逆走法就能回到奇数步之前的局面
+// 只处理期间双方都没有将军的情况，此时重复判为和棋；涉及长将的仍由detectRepeat在走棋后判断
+bool SlimBoard::hasUpcomingRepeat()
+{
+    uint64_t key = zoCurr_.getKey();
+    int size = static_cast<int>(records_.size());
 
-    for (unsigned int i = records_.size() - 1; i >= 0; ++i) // 由底向上搜索
+    for (int i = 1; i <= size; i++)
     {
-        const TRecord& record = records_.at(i);
+        const TRecord& record = records_.at(size - i);
 
-        if (record.capture != 0) // 有吃子即可结束搜索
+        if (record.capture != 0 || record.move == 0 || record.check != board::CHECK_no) // 有吃子、空着或将军即可结束搜索
         {
-            break;
+            return false;
         }
 
-        if (player == player_)
+        if (i < 3 || (i & 1) == 0) // 之前轮到对方走棋的局面
         {
-            selfPerpetualCheck = selfPerpetualCheck && record.check;
+            continue;
+        }
+
+        // 回到的局面本身也不能是将军
+        if (size - i == 0 || records_.at(size - i - 1).check != board::CHECK_no)
+        {
+            return false;
+        }
 
-            if (record.key == zoCurr_.getKey())
+        uint64_t diff = key ^ record.key;
+        int slot = cuckooHash1(diff);
+        if (g_cuckooKeys[slot] != diff)
+        {
+            slot = cuckooHash2(diff);
+            if (g_cuckooKeys[slot] != diff)
             {
-                if (--count == 0)
-                {
-                    return 1 + (selfPerpetualCheck ? 2 : 0) + (ememyPerpetualCheck ? 4 : 0);
-                }
+                continue;
             }
         }
-        else
+
+        // 表中走法的方向不确定，有棋子的一端为起点；走法路径上不能有棋子阻挡
+        uint8_t src = extractSrc(g_cuckooMoves[slot]);
+        uint8_t dst = extractDst(g_cuckooMoves[slot]);
+        if (board_[src] == 0)
         {
-            ememyPerpetualCheck = ememyPerpetualCheck && record.check;
+            std::swap(src, dst);
         }
 
-        def::switchPlayer(player);
+        if (board_[src] == g_cuckooIcons[slot] && board_[dst] == 0 && isValidMove(synthesisMove(src, dst)))
+        {
+            return true;
+        }
     }
 
-    return 0;
+    return false;
 }
 
 int SlimBoard::getRepeatScore(int status)
 {
     assert (status != 0);
 
-    int res = 0;
-
-    if (status & 2)
-    {
-        res += distance_ - g_scoreCheckmate;
-    }
-
-    if (status & 4)
-    {
-        res += g_scoreCheckmate - distance_;
-    }
-
-    if (res == 0)
-    {
-        res = -g_scoreDraw;
-    }
-
-    return res;
+    return board::getRepeatScore(status, distance_);
 }
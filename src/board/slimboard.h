@@ -2,14 +2,21 @@
 #define SLIMBOARD_H
 
 #include "board/board.h"
+#include "board/movelist.h"
+#include "board/transtable.h"
+#include "board/timemanager.h"
+#include "board/searchutil.h"
 #include "util/zobrist.h"
 #include "util/mystack.h"
 
 #include <vector>
 #include <stack>
+#include <memory>
+#include <atomic>
 
 using std::vector;
 using std::stack;
+using std::shared_ptr;
 
 class SlimBoard : public board::IBoard
 {
@@ -21,25 +28,154 @@ public:
     virtual uint8_t makeMove(def::TMove move);              // 指定走法走棋,返回EMoveRet的组合
     virtual bool undoMakeMove();                            // 悔棋
 
+    virtual shared_ptr<board::IBoard> clone() const;        // 复制当前局面，供后台线程搜索
+    virtual bool searchMove(def::TMove& move);              // 搜索最佳走法但不走棋，被中止则返回false
+    virtual void stopSearch();                              // 中止正在进行的搜索，可在其他线程调用
+    virtual void setPonder(bool on);                        // 后台思考模式下不受时间限制，解除后计入已用时间
+    virtual def::TMove getPonderMove() const;               // 主要变例中最佳走法之后的对方应着
+    virtual void setInfoCallback(const board::InfoCallback& callback);// 主线程每完成一层迭代回调一次
+
     virtual int getScore(def::PLAYER_E player) const;       // 获取当前局面下的玩家分数
     virtual def::ICON_E getIcon(def::TPos pos) const;       // 获取某一位置的棋子
     virtual def::PLAYER_E getOwner(def::TPos pos) const;    // 获取pos棋子所属玩家
     virtual def::PLAYER_E getNextPlayer() const;            // 获取下一走棋玩家
     virtual def::TMove getTrigger() const;                  // 表示该snapshot是由trigger的两个位置移动产生的，用于绘制select图标
 
+public:
+    // 搜索统计
+    struct TSearchStats
+    {
+        int      threads;  // 线程数
+        int      depth;    // 主线程完成的深度
+        uint64_t nodes;    // 所有线程的节点数之和
+        double   seconds;  // 耗时
+        uint64_t nps;      // 每秒节点数
+        double   firstCutRate;// beta截断中由第一个走法产生的比例，衡量走法排序的好坏
+    };
+
+    // 可调的搜索参数
+    struct TSearchParams
+    {
+        int    lmrMinDepth;  // 后期走法减少(LMR)的最小深度
+        int    lmrMinMoves;  // 前几个走法不减少
+        double lmrBase;      // 减少层数 = lmrBase + ln(深度) * ln(走法序号) / lmrDivisor
+        double lmrDivisor;
+        int    lmpMaxDepth;  // 后期走法裁剪(LMP)的最大深度
+        int    lmpBase;      // 搜索过lmpBase + 深度 * 深度个走法后，裁剪剩下的不吃子走法
+        int    futilityMaxDepth;// 前沿节点的最大深度
+        int    futilityMargin;  // 每层的余量，局面分加上余量 * 深度仍不超过alpha时裁剪不吃子走法
+        int    razorMaxDepth;   // 剃刀裁剪的最大深度
+        int    razorMargin;     // 每层的余量，局面分加上余量 * 深度仍低于alpha时直接进入静态搜索
+        int    iidMinDepth;     // 没有置换表走法时，pv节点从此深度开始内部迭代加深，非pv节点再深两层
+        int    iidReduction;    // 内部迭代加深减少的层数
+    };
+
+    void setSearchParams(const TSearchParams& params);// 设置搜索参数，重新计算减少层数表
+    const TSearchParams& getSearchParams() const;
+
+    // 多主要变例分析的一个变例
+    struct TAnalysisLine
+    {
+        def::TMove         move; // 根节点走法
+        int                score;// 相对于当前走棋方的分数
+        int                depth;// 完成的深度
+        vector<def::TMove> pv;   // 主要变例，第一个走法即move
+    };
+
+    void analyze(int lineNum, vector<TAnalysisLine>& lines);// 多主要变例分析，按分数从高到低返回前lineNum个走法，受搜索限制控制
+
+    void setSearchLimits(const TimeManager::TLimits& limits);// 设置搜索的时间、节点数、深度限制
+    const TimeManager::TLimits& getSearchLimits() const;
+
+    void setThreadNum(int num);// 设置搜索线程数(Lazy SMP)，1为单线程
+    int getThreadNum() const;
+    const TSearchStats& getSearchStats() const;// 最近一次fullSearch的统计
+    void benchmark(int maxThreads, vector<TSearchStats>& stats);// 分别以1、2、4...maxThreads个线程搜索当前局面，统计nps
+    uint64_t perft(int depth);// 统计depth层的合法走法路径数，用于与BitBoard对照走法生成
+
+protected:
+    // 走法生成的类型
+    enum GEN_E
+    {
+        GEN_all,    // 所有走法
+        GEN_capture,// 只生成吃子走法
+        GEN_quiet,  // 只生成不吃子走法
+    };
+
+    // 走法的合法性
+    enum LEGAL_E
+    {
+        LEGAL_no,
+        LEGAL_yes,
+        LEGAL_unknown,// 需要走棋后判断是否被将军
+    };
+
+    // 判断走法合法性所需的局面信息，每个节点计算一次
+    struct TLegalInfo
+    {
+        bool     inCheck;    // 当前玩家是否被将军
+        uint8_t  kingIdx;    // 当前玩家的将的坐标
+        uint8_t  pinned[12]; // 离开原位置后可能使己方被将军的棋子：车、将牵制的，作为对方炮的两个炮架之一的，以及挡住对方马腿的
+        int      pinnedNum;
+        uint16_t screens[2]; // 将所在行、列上将与对方炮之间的空位，走到这里会成为炮架，第0个为行上的列位，第1个为列上的行位
+    };
+
+    // 走法选择器的阶段
+    enum PICK_E
+    {
+        PICK_hash,          // 置换表走法，不需要生成
+        PICK_genCaptures,   // 生成吃子走法
+        PICK_captures,      // 按MVV/LVA逐个选出吃子走法
+        PICK_killers,       // 杀手走法及反驳走法
+        PICK_genQuiets,     // 生成不吃子走法
+        PICK_quiets,        // 按历史分值排序的不吃子走法
+        PICK_badCaptures,   // 静态交换评估为负的吃子走法，放到最后
+        PICK_end,
+    };
+
+    // 分阶段的走法选择器，大部分beta截断发生在生成不吃子走法之前
+    struct TMovePicker
+    {
+        int      stage;
+        int      index;
+        uint16_t hashMove;
+        uint16_t killers[3];// 两个杀手走法及反驳走法
+        MoveList moves;
+        MoveList badCaptures;// 亏子的吃子走法
+    };
+
 protected:
     // 内部使用一维坐标更为高效
     inline def::ICON_E getIcon(uint8_t idx) const;
     inline def::PLAYER_E getOwner(uint8_t idx) const;
     inline uint8_t getValue(def::ICON_E icon, uint8_t idx) const;
 
-    uint8_t makeMove(uint16_t move);// 内部使用
+    uint8_t makeMove(uint16_t move);// 内部使用，计算完整的走棋状态
+    bool doMove(uint16_t move, bool legal = false);// 搜索使用，只更新局面，自杀则返回false；legal为true表示已确认走法合法
+    void undoMove();
+    void makeNullMove();// 空着，只交换走棋方，供空着裁剪使用
+    void undoNullMove();
+    inline bool hasAttackers(def::PLAYER_E player) const;// player是否还有车、马、炮
+    bool givesCheck();// 上一步走法是否将军，按需计算
     
     uint8_t movePiece(uint16_t move);
     void undoMovePiece(uint16_t move, uint8_t capture);
 
-    void generateAllMoves(vector<uint16_t>& moves, bool capture = false) const;// 生成当前局面所有合法走法
+    void generateAllMoves(MoveList& moves, GEN_E type = GEN_all) const;// 生成当前局面所有合法走法
+    void generateSlides(MoveList& moves, uint8_t src, bool cannon, GEN_E type) const;// 查行、列占用表生成车、炮的走法
+    inline bool isGenTarget(uint8_t dst, GEN_E type) const;
+    void generateLegalMoves(MoveList& moves, GEN_E type = GEN_all);// 只生成不会导致己方被将军的走法
+    void initLegalInfo(TLegalInfo& info);// 计算当前局面的将军、牵制及炮架信息
+    LEGAL_E isLegalMove(uint16_t move, const TLegalInfo& info);// 伪合法走法是否合法，多数走法无需走棋即可判断
+
+    void initPicker(TMovePicker& picker, uint16_t hashMove);
+    uint16_t nextMove(TMovePicker& picker);// 依次返回下一个待搜索的走法，返回0表示已取完
+    void updateKillers(uint16_t move);// 不吃子走法产生beta截断时更新杀手走法及反驳走法
+    inline int16_t& getHistory(uint16_t move);// 当前玩家走法的历史分值
+    void updateHistory(uint16_t move, int bonus);// 按bonus更新历史分值，越接近上限增加越慢
+    void ageHistory();// 新一轮搜索前衰减历史分值
     void initScore();
+    void initZobrist();
 
     // 相关算法
     int evaluate(def::PLAYER_E player) const;// 评价函数，相当重要
@@ -50,16 +186,35 @@ protected:
     int alphabetaWithNega(int depth, int alpha, int beta, uint16_t* pNextMove);
     // 下面是真正使用的算法
     uint16_t fullSearch();// 迭代加深的alpha-beta完全搜索
+    void newSearch();// 新一轮搜索前的准备
+    uint16_t iterativeDeepening(int threadId);// 单个线程的迭代加深，threadId为0的是主线程
+    int aspirationSearch(int depth, int score, uint16_t* pNextMove);// 以上一层的分数score为中心，用渴望窗口搜索根节点
+    void getPV(uint16_t move, vector<uint16_t>& pv);// 从置换表中取出以move开始的主要变例
+    void getRootPV(vector<uint16_t>& pv);// 刚完成的根节点搜索的主要变例
+    inline void updatePV(uint16_t move);// 以move及其子节点的主要变例作为当前节点的主要变例
+    inline def::TMove toMove(uint16_t move) const;
+    inline uint64_t getKey() const;// 当前局面的Zobrist键值
+    inline bool isStopped() const;
+    inline void pollLimits();// 主线程每隔一定节点数检查硬限制
     int quiescentSearch(int alpha, int beta);// 静态搜索
+    int see(uint16_t move);// 静态交换评估，返回吃子方在dst上交换完毕后的子力得失
+    inline bool isGoodCapture(uint16_t move);// 吃子走法是否不亏子
+    uint8_t getLeastAttacker(uint8_t dst, def::PLAYER_E player) const;// player攻击dst的价值最低的棋子坐标，没有则返回0
     int alphabetaWithNegaSearch(int depth, int alpha, int beta, uint16_t* pNextMove);
 
     // 基础函数
     bool isValidMove(uint16_t move);
     bool isCheck();// 当前玩家是否被将军
-    bool isCheckmate();// 当前玩家是否被将死
+    bool isCheckingMove(uint16_t move);// 走法是否将军对方，无需走棋即可判断
+    bool isKingAttacked(uint8_t kingIdx, def::PLAYER_E player) const;// player方kingIdx上的将是否被对方攻击
+    bool isCheckmate();// 当前玩家是否没有合法走法(被将死或困毙)
     
     void addIcon(uint8_t idx, def::ICON_E icon);
     void delIcon(uint8_t idx, def::ICON_E icon);
+    inline void addPiece(uint8_t idx, def::ICON_E icon);// 在棋子列表中为idx上的棋子分配序号
+    inline void delPiece(uint8_t idx);
+    inline void flipOccupancy(uint8_t idx);// 翻转idx所在行、列的占用位
+    void initPieces();// 根据棋盘建立棋子列表
     void updateKingIdx(def::PLAYER_E player, uint8_t idx);
 
     inline bool isInSquare(uint8_t idx) const;
@@ -89,17 +244,21 @@ protected:
     inline uint8_t findKing(def::PLAYER_E player) const;
 
     int detectRepeat(int count);
+    bool hasUpcomingRepeat();// 当前玩家能否走一步可逆走法回到之前的局面
     int getRepeatScore(int status);
 
 private:
+    template <typename Board>
+    friend void board::getPV(Board& board, const TransTable& tt, uint16_t move, int maxLen, std::vector<uint16_t>& pv);
+
     struct TRecord
     {
         uint16_t move;     // 当前走法
         uint8_t  capture;  // 走棋后dst坐标被捕获的棋子
-        bool     check;    // 走棋后是否能将军
-        uint16_t key;      // 走棋前局面的校验码
+        uint8_t  check;    // 走棋后是否能将军，见board::CHECK_E
+        uint64_t key;      // 走棋前局面的Zobrist键值
 
-        TRecord(uint16_t Move, uint8_t Capture, bool Check, uint16_t Key)
+        TRecord(uint16_t Move, uint8_t Capture, uint8_t Check, uint64_t Key)
             : move(Move)
             , capture(Capture)
             , check(Check)
@@ -111,7 +270,15 @@ private:
 
 private:
     uint8_t  board_[256];
-    uint16_t cache_[65536];
+    uint8_t  pieces_[48];       // 棋子列表，值为坐标，0表示已被吃；红方16~31、黑方32~47，每类棋子占用固定的序号范围
+    uint8_t  pieceSlots_[256];  // 坐标上的棋子在pieces_中的序号，0表示没有棋子
+    uint16_t rankOcc_[10];      // 各行的占用位，第col位表示第col列
+    uint16_t fileOcc_[9];       // 各列的占用位，第row位表示第row行
+    int16_t  history_[2][65536];// 历史表，以走棋方及走法(起点、终点)为下标
+    uint16_t killers_[64][2];   // 每层两个杀手走法
+    uint16_t counters_[24][256];// 反驳走法，以上一步走法的棋子及终点为下标
+    uint16_t pvTable_[64][64];  // 三角形主要变例表，第i行是距根节点i步的节点从第i列开始的主要变例
+    uint8_t  pvLength_[64];     // 各行主要变例的结束列
 
     int distance_;
 
@@ -121,12 +288,41 @@ private:
     int redScore_;
     int blackScore_;
 
+    int redAttackers_;  // 红方车、马、炮的数量
+    int blackAttackers_;// 黑方车、马、炮的数量
+
     def::PLAYER_E winner_;
     def::PLAYER_E player_;
 
     MyStack<TRecord> records_;
+    uint16_t repeatCounts_[4096];// records_中各键值低12位出现的次数，为0时不可能重复
+
+    Zobrist zoCurr_;
+
+    shared_ptr<TransTable> tt_;// 置换表，多线程搜索时共享
+
+    int threadNum_;
+    uint64_t nodes_;// 本线程搜索的节点数
+    uint64_t cutoffs_;// beta截断的次数
+    uint64_t firstCutoffs_;// 第一个走法即产生beta截断的次数
+    int depth_;// 本线程完成的深度
+    TSearchParams params_;
+    uint8_t reductions_[33][MoveList::CAPACITY];// LMR减少的层数，以深度和走法序号为下标
+
+    int extensions_;// 当前路线上已使用的将军延伸层数
 
-    Zobrist zoCurr_;    
+    int nullMinPly_;// 空着验证搜索期间，nullPlayer_在此步数之前不能走空着
+    def::PLAYER_E nullPlayer_;
+    shared_ptr<std::atomic<bool>> stop_;// 中止标志
+    TimeManager timeManager_;
+    bool pollLimits_;// 是否轮询时间限制，只有fullSearch的主线程轮询
+    bool timeout_;// 超过硬限制或节点数上限
+    shared_ptr<std::atomic<bool>> ponder_;// 后台思考模式
+    uint16_t ponderMove_;// 预测的对方应着
+    vector<uint16_t> pv_;// 最近完成的一层迭代的主要变例
+    board::InfoCallback infoCallback_;
+    MoveList excluded_;// 多主要变例分析时根节点排除的走法
+    TSearchStats stats_;
 };
 
 #endif // SLIMBOARD_H
@@ -0,0 +1,108 @@
+#include "timemanager.h"
+
+#include <algorithm>
+
+static const TimeManager::TLimits g_defaultLimits = {1000, 3000, 0, 0};
+
+static const double g_scaleChanged  = 1.5; // 最佳走法变化时软限制的放大系数
+static const double g_scaleMax      = 3.0;
+static const double g_scaleDominant = 0.5; // 最佳走法长时间不变时软限制的缩小系数
+static const int    g_stableDepth   = 4;   // 连续不变的层数达到此值即认为最佳走法占优
+static const int    g_scoreDrop     = 30;  // 分数下降超过此值则不认为占优
+
+TimeManager::TimeManager()
+    : limits_(g_defaultLimits)
+    , start_(std::chrono::steady_clock::now())
+    , scale_(1.0)
+    , bestMove_(0)
+    , bestScore_(0)
+    , stable_(0)
+{
+
+}
+
+void TimeManager::setLimits(const TLimits& limits)
+{
+    limits_ = limits;
+}
+
+const TimeManager::TLimits& TimeManager::getLimits() const
+{
+    return limits_;
+}
+
+// 开始计时
+void TimeManager::start()
+{
+    start_ = std::chrono::steady_clock::now();
+    scale_ = 1.0;
+    bestMove_ = 0;
+    bestScore_ = 0;
+    stable_ = 0;
+}
+
+// 已用时间(ms)
+int64_t TimeManager::elapsed() const
+{
+    return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start_).count();
+}
+
+// 搜索中途是否超过硬限制或节点数上限
+bool TimeManager::isHardLimit(uint64_t nodes) const
+{
+    if (limits_.nodes != 0 && nodes >= limits_.nodes)
+    {
+        return true;
+    }
+
+    return limits_.hardMs != 0 && elapsed() >= limits_.hardMs;
+}
+
+// 每完成一层调用
+void TimeManager::onIteration(uint16_t bestMove, int score)
+{
+    if (bestMove_ != 0 && bestMove != bestMove_) // 最佳走法变化，局面尚不明朗，延长软限制
+    {
+        scale_ = std::min(scale_ * g_scaleChanged, g_scaleMax);
+        stable_ = 0;
+    }
+    else if (score < bestScore_ - g_scoreDrop) // 分数明显下降，撤销缩短，至少恢复到默认软限制
+    {
+        scale_ = std::max(scale_, 1.0);
+        stable_ = 0;
+    }
+    else if (++stable_ >= g_stableDepth) // 最佳走法占优，提前结束
+    {
+        scale_ = g_scaleDominant;
+    }
+
+    bestMove_ = bestMove;
+    bestScore_ = score;
+}
+
+// 完成depth层后是否停止
+bool TimeManager::shouldStop(int depth, uint64_t nodes) const
+{
+    if (limits_.depth != 0 && depth >= limits_.depth)
+    {
+        return true;
+    }
+
+    if (limits_.nodes != 0 && nodes >= limits_.nodes)
+    {
+        return true;
+    }
+
+    if (limits_.softMs == 0)
+    {
+        return false;
+    }
+
+    double soft = limits_.softMs * scale_;
+    if (limits_.hardMs != 0)
+    {
+        soft = std::min(soft, static_cast<double>(limits_.hardMs));
+    }
+
+    return elapsed() >= soft;
+}
@@ -0,0 +1,56 @@
+#ifndef TIMEMANAGER_H
+#define TIMEMANAGER_H
+
+#include <stdint.h>
+
+#include <chrono>
+#include <atomic>
+
+// 搜索的时间管理，使用单调时钟计时，与CPU时间和线程数无关
+// 软限制在每完成一层后检查，决定是否开始下一层；硬限制在搜索中途按节点数轮询，超过即中止
+class TimeManager
+{
+public:
+    // 搜索限制，各项为0表示不限
+    struct TLimits
+    {
+        int      softMs;// 软限制(ms)
+        int      hardMs;// 硬限制(ms)
+        uint64_t nodes; // 主线程节点数上限
+        int      depth; // 深度上限
+    };
+
+    static const uint64_t POLL_MASK = 1023;// 每1024个节点轮询一次硬限制
+
+public:
+    TimeManager();
+
+    void setLimits(const TLimits& limits);
+    const TLimits& getLimits() const;
+
+    void start();// 开始计时
+    int64_t elapsed() const;// 已用时间(ms)
+
+    bool isHardLimit(uint64_t nodes) const;// 搜索中途是否超过硬限制或节点数上限
+
+    // 搜索中每个节点调用，每POLL_MASK + 1个节点检查一次硬限制；至少完成一层之后才检查，保证总有走法可走，后台思考时不检查
+    bool pollHardLimit(uint64_t nodes, int depth, const std::atomic<bool>& ponder) const
+    {
+        return depth > 0 && (nodes & POLL_MASK) == 0 && !ponder.load(std::memory_order_relaxed) && isHardLimit(nodes);
+    }
+
+    void onIteration(uint16_t bestMove, int score);// 每完成一层调用，最佳走法变化时延长软限制，长时间不变时缩短
+    bool shouldStop(int depth, uint64_t nodes) const;// 完成depth层后是否停止
+
+private:
+    TLimits limits_;
+
+    std::chrono::steady_clock::time_point start_;
+
+    double   scale_;    // 软限制的伸缩系数
+    uint16_t bestMove_; // 上一层的最佳走法
+    int      bestScore_;// 上一层的分数
+    int      stable_;   // 最佳走法连续不变的层数
+};
+
+#endif // TIMEMANAGER_H
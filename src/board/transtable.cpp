@@ -0,0 +1,117 @@
+#include "transtable.h"
+
+TransTable::TransTable(size_t mb/* = 16*/)
+    : size_(0)
+    , mask_(0)
+    , age_(0)
+{
+    resize(mb);
+}
+
+// 重新分配大小(MB)，实际表项数向下取2的幂
+// 注意：不能与搜索并发调用
+void TransTable::resize(size_t mb)
+{
+    size_t count = 1;
+    size_t limit = (mb == 0 ? 1 : mb) * 1024 * 1024 / sizeof(TSlot);
+
+    while (count * 2 <= limit)
+    {
+        count *= 2;
+    }
+
+    slots_.reset(new TSlot[count]);
+    size_ = count;
+    mask_ = count - 1;
+    clear();
+}
+
+// 清空
+void TransTable::clear()
+{
+    for (size_t i = 0; i < size_; i++)
+    {
+        slots_[i].key.store(0, std::memory_order_relaxed);
+        slots_[i].data.store(0, std::memory_order_relaxed);
+    }
+
+    age_ = 0;
+}
+
+// 开始新一轮搜索
+void TransTable::newSearch()
+{
+    age_ = (age_ + 1) & 0x3f; // age只有6位
+}
+
+uint64_t TransTable::pack(const TEntry& entry)
+{
+    return static_cast<uint64_t>(entry.move) |
+           (static_cast<uint64_t>(static_cast<uint16_t>(entry.score)) << 16) |
+           (static_cast<uint64_t>(static_cast<uint8_t>(entry.depth)) << 32) |
+           (static_cast<uint64_t>(entry.flag) << 40);
+}
+
+TransTable::TEntry TransTable::unpack(uint64_t data)
+{
+    TEntry entry;
+    entry.move  = static_cast<uint16_t>(data);
+    entry.score = static_cast<int16_t>(data >> 16);
+    entry.depth = static_cast<int8_t>(data >> 32);
+    entry.flag  = static_cast<uint8_t>(data >> 40);
+    return entry;
+}
+
+bool TransTable::probe(uint64_t key, TEntry& entry) const
+{
+    const TSlot& slot = slots_[key & mask_];
+    uint64_t data = slot.data.load(std::memory_order_relaxed);
+
+    if (data == 0 || (slot.key.load(std::memory_order_relaxed) ^ data) != key)
+    {
+        return false;
+    }
+
+    entry = unpack(data);
+    return true;
+}
+
+void TransTable::store(uint64_t key, uint16_t move, int score, int depth, BOUND_E bound)
+{
+    TSlot& slot = slots_[key & mask_];
+    uint64_t data = slot.data.load(std::memory_order_relaxed);
+    uint8_t age = age_.load(std::memory_order_relaxed);
+
+    // 替换策略：不同局面、旧的搜索、更深的搜索或精确值才替换
+    if (data != 0)
+    {
+        TEntry old = unpack(data);
+
+        if ((slot.key.load(std::memory_order_relaxed) ^ data) == key)
+        {
+            if (move == 0) // 没有走法时保留原来的走法
+            {
+                move = old.move;
+            }
+
+            if (depth < old.depth - 2 && bound != BOUND_exact && old.getAge() == age)
+            {
+                return;
+            }
+        }
+        else if (old.getAge() == age && depth < old.depth && bound != BOUND_exact)
+        {
+            return;
+        }
+    }
+
+    TEntry entry;
+    entry.move  = move;
+    entry.score = static_cast<int16_t>(score);
+    entry.depth = static_cast<int8_t>(depth);
+    entry.flag  = static_cast<uint8_t>((age << 2) | bound);
+
+    data = pack(entry);
+    slot.key.store(key ^ data, std::memory_order_relaxed);
+    slot.data.store(data, std::memory_order_relaxed);
+}
@@ -0,0 +1,67 @@
+#ifndef TRANSTABLE_H
+#define TRANSTABLE_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include <atomic>
+#include <memory>
+
+// 置换表，以局面的64位Zobrist键值为索引
+// 表项数量为2的幂，低位作为下标；多线程共享时无锁访问：
+// 每个表项保存 key^data 与 data 两个64位字，读出后异或校验，被并发写坏的表项自然校验失败
+class TransTable
+{
+public:
+    // 分值的边界类型
+    enum BOUND_E
+    {
+        BOUND_none  = 0x0,
+        BOUND_upper = 0x1,// 分值不高于score(fail-low)
+        BOUND_lower = 0x2,// 分值不低于score(fail-high)
+        BOUND_exact = 0x3,// 精确值(pv节点)
+    };
+
+    // 解包后的表项
+    struct TEntry
+    {
+        uint16_t move;  // 最佳走法
+        int16_t  score; // 分值
+        int8_t   depth; // 搜索深度
+        uint8_t  flag;  // 低2位为bound，高6位为age
+
+        BOUND_E getBound() const { return static_cast<BOUND_E>(flag & 0x3); }
+        uint8_t getAge() const { return flag >> 2; }
+    };
+
+public:
+    explicit TransTable(size_t mb = 16);
+
+    void resize(size_t mb);// 重新分配大小(MB)，实际表项数向下取2的幂
+    void clear();// 清空
+    void newSearch();// 开始新一轮搜索，增加age使旧表项优先被替换
+
+    bool probe(uint64_t key, TEntry& entry) const;
+    void store(uint64_t key, uint16_t move, int score, int depth, BOUND_E bound);
+
+    size_t size() const { return size_; }
+
+private:
+    // 打包后的表项：data低16位move，其后依次为score、depth、flag
+    struct TSlot
+    {
+        std::atomic<uint64_t> key; // key ^ data
+        std::atomic<uint64_t> data;
+    };
+
+    static uint64_t pack(const TEntry& entry);
+    static TEntry unpack(uint64_t data);
+
+private:
+    std::unique_ptr<TSlot[]> slots_;
+    size_t size_;
+    size_t mask_;
+    std::atomic<uint8_t> age_;
+};
+
+#endif // TRANSTABLE_H
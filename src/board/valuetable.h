@@ -0,0 +1,12 @@
+#ifndef VALUETABLE_H
+#define VALUETABLE_H
+
+#include <stdint.h>
+
+namespace board
+{
+    // 红方各类棋子在16x16棋盘各位置的子力价值(含位置分)，第一维为PIECE_E减一；黑方使用翻转后的坐标(254 - idx)
+    extern const uint8_t g_redValue[7][256];
+}
+
+#endif // VALUETABLE_H
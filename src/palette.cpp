@@ -1,8 +1,10 @@
 #include "palette.h"
 #include "chess.h"
 #include "resmgr.h"
+#include "searchservice.h"
 #include "board/naiveboard.h"
 #include "board/slimboard.h"
+#include "board/bitboard.h"
 #include "util/co.h"
 #include "util/debug.h"
 
@@ -23,14 +25,22 @@ Palette::Palette(Chess* chess, QLabel* bg, ResMgr* resMgr)
     , resMgr_(resMgr)
     , bg_(bg)
     , prevPos_(def::INVALID_POS)
+    , enginePlayer_(def::PLAYER_none)
 {
     assert(chess_ != nullptr);   
     assert(bg_ != nullptr);
     assert(resMgr_ != nullptr);    
 
     // board_ = std::make_shared<NaiveBoard>();
+    // board_ = std::make_shared<BitBoard>();
     board_ = std::make_shared<SlimBoard>();
 
+    // 电脑走棋在后台线程搜索，moveFound已由SearchService在GUI线程中发出，直接连接，
+    // 不能再次排队，否则排队期间悔棋或开局后过期的走法会被用在新局面上
+    searchService_ = std::make_shared<SearchService>();
+    QObject::connect(searchService_.get(), &SearchService::moveFound, chess_,
+                     [this](TMove move, TMove ponder) { onMoveFound(move, ponder); }, Qt::DirectConnection);
+
     initLabels();
     initIcons();
 }
@@ -79,6 +89,9 @@ void Palette::initIcons()
 
 void Palette::open()
 {
+    searchService_->cancel();
+    enginePlayer_ = def::PLAYER_none; // 新开局由玩家先走，电脑不自动应着
+
     board_->init();
     drawIcons();
 
@@ -188,6 +201,8 @@ void Palette::rotate(bool on)
 
 void Palette::undo()
 {
+    searchService_->cancel();
+
     if (board_->undoMakeMove())
     {
         drawIcons();
@@ -199,18 +214,51 @@ void Palette::undo()
 
 void Palette::run()
 {
-    if (board_->autoMove())
+    if (searchService_->isSearching())
+    {
+        return;
+    }
+
+    // 此后电脑执当前走棋方，玩家每走一步都自动应着
+    enginePlayer_ = board_->getNextPlayer();
+
+    // 搜索局面副本，避免GUI线程卡顿
+    searchService_->start(board_->clone());
+}
+
+void Palette::onMoveFound(TMove move, TMove ponder)
+{
+    uint8_t ret = board_->makeMove(move);
+
+    if (ret & board::MOVE_RET_ok)
     {
         drawIcons();
         // 重绘select
         TMove trigger = board_->getTrigger();
         drawSelect(trigger);
     }
+
+    // 对方思考期间，在猜测对方走了ponder之后的局面上后台思考
+    if ((ret & board::MOVE_RET_ok) && !(ret & board::MOVE_RET_dead) && co::isValidPos(ponder.src))
+    {
+        shared_ptr<board::IBoard> snapshot = board_->clone();
+
+        if (snapshot->makeMove(ponder) & board::MOVE_RET_ok)
+        {
+            searchService_->ponder(snapshot, ponder);
+        }
+    }
 }
 
 // currPos是屏幕上的pos，需要翻转
 void Palette::click(TPos currPos)
 {
+    // 电脑思考期间不能走棋
+    if (searchService_->isSearching())
+    {
+        return;
+    }
+
     // 翻转
     if (rotate_)
     {
@@ -249,6 +297,21 @@ void Palette::click(TPos currPos)
         {
             // 显示两个选择框，prevPos_清空
             drawSelect({prevPos_, currPos});
+
+            // 轮到电脑执的一方时自动应着：后台思考猜中则转为正常搜索；没猜中或没有后台思考则按当前局面搜索，
+            // 中止的后台思考留在置换表中的结果仍可复用
+            if (board_->getNextPlayer() == enginePlayer_ && !(ret & board::MOVE_RET_dead))
+            {
+                if (!searchService_->ponderHit({prevPos_, currPos}))
+                {
+                    run();
+                }
+            }
+            else // 不需要电脑应着，中止可能存在的后台思考
+            {
+                searchService_->cancel();
+            }
+
             prevPos_ = def::INVALID_POS;
         }
         else // 不能移动棋子
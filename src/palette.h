@@ -9,6 +9,7 @@
 #include <memory>
 
 class Chess;
+class SearchService;
 class QLabel;
 class QPixmap;
 class QMediaPlaylist;
@@ -48,6 +49,8 @@ protected:
     void drawSelect(TMove move);
     uint8_t makeMove(TMove move);
 
+    void onMoveFound(TMove move, TMove ponder);// 后台搜索完成，ponder为预测的对方应着
+
 private:
     bool soundEffect_;
     bool rotate_;
@@ -55,6 +58,7 @@ private:
     Chess* chess_;   
     ResMgr* resMgr_;
     shared_ptr<board::IBoard> board_;
+    shared_ptr<SearchService> searchService_;
 
     QLabel* bg_;
     shared_ptr<QLabel> prevSelect_;
@@ -62,6 +66,7 @@ private:
     vector<vector<shared_ptr<QLabel>>> icons_;
 
     TPos prevPos_;
+    def::PLAYER_E enginePlayer_;// 电脑执的一方，玩家走棋后自动应着；PLAYER_none表示不自动应着
 
     shared_ptr<QMediaPlaylist> mediaPlayList_;
     shared_ptr<QMediaPlayer> mediaPlayer_;
@@ -0,0 +1,152 @@
+#include "searchservice.h"
+
+SearchService::SearchService(QObject* parent/* = nullptr*/)
+    : QObject(parent)
+    , id_(0)
+    , searching_(false)
+    , pondering_(false)
+    , ponderFinished_(false)
+    , ponderOk_(false)
+{
+    qRegisterMetaType<def::TMove>("def::TMove");
+    qRegisterMetaType<board::TSearchInfo>("board::TSearchInfo");
+
+    // 工作线程发出的信号排队到本对象所在的GUI线程处理
+    connect(this, &SearchService::searchFinished, this, &SearchService::onSearchFinished, Qt::QueuedConnection);
+    connect(this, &SearchService::infoFound, this, &SearchService::onInfoFound, Qt::QueuedConnection);
+}
+
+SearchService::~SearchService()
+{
+    cancel();
+    join();
+}
+
+// 在工作线程中搜索snapshot，snapshot不再与GUI线程共享
+void SearchService::start(shared_ptr<board::IBoard> snapshot)
+{
+    cancel();
+    join();
+
+    snapshot_ = snapshot;
+    searching_ = true;
+
+    quint64 id = ++id_;
+    snapshot->setInfoCallback([this, id](const board::TSearchInfo& info) { emit infoFound(id, info); });
+    worker_ = std::thread([this, snapshot, id]()
+    {
+        def::TMove move = def::INVALID_MOVE;
+        bool ok = snapshot->searchMove(move);
+
+        emit searchFinished(id, move, snapshot->getPonderMove(), ok);
+    });
+}
+
+// 后台思考：搜索不受时间限制，直到ponderHit或cancel
+void SearchService::ponder(shared_ptr<board::IBoard> snapshot, def::TMove predicted)
+{
+    snapshot->setPonder(true);
+    start(snapshot);
+
+    searching_ = false;
+    pondering_ = true;
+    predicted_ = predicted;
+}
+
+// 猜中则解除后台思考模式，已用的时间计入本步，搜索很快结束
+bool SearchService::ponderHit(def::TMove move)
+{
+    if (!pondering_)
+    {
+        return false;
+    }
+
+    if (!(move == predicted_))
+    {
+        cancel();
+        return false;
+    }
+
+    pondering_ = false;
+    searching_ = true;
+
+    if (ponderFinished_) // 后台思考已经结束，直接使用其结果
+    {
+        onSearchFinished(id_, ponderMove_, ponderReply_, ponderOk_);
+    }
+    else
+    {
+        snapshot_->setPonder(false);
+    }
+
+    return true;
+}
+
+// 中止当前搜索，其结果将被丢弃
+void SearchService::cancel()
+{
+    ++id_;
+    searching_ = false;
+    pondering_ = false;
+    ponderFinished_ = false;
+
+    if (snapshot_)
+    {
+        snapshot_->stopSearch();
+    }
+}
+
+bool SearchService::isSearching() const
+{
+    return searching_;
+}
+
+bool SearchService::isPondering() const
+{
+    return pondering_;
+}
+
+void SearchService::onSearchFinished(quint64 id, def::TMove move, def::TMove ponder, bool ok)
+{
+    if (id != id_) // 已被取消或被新的搜索取代
+    {
+        return;
+    }
+
+    if (pondering_) // 还没有确定是否猜中，先保存结果
+    {
+        ponderFinished_ = true;
+        ponderOk_ = ok;
+        ponderMove_ = move;
+        ponderReply_ = ponder;
+        return;
+    }
+
+    searching_ = false;
+    ponderFinished_ = false;
+    snapshot_.reset();
+    join();
+
+    if (ok)
+    {
+        emit moveFound(move, ponder);
+    }
+}
+
+void SearchService::onInfoFound(quint64 id, board::TSearchInfo info)
+{
+    if (id != id_) // 已被取消或被新的搜索取代
+    {
+        return;
+    }
+
+    emit searchInfo(info);
+}
+
+void SearchService::join()
+{
+    if (worker_.joinable())
+    {
+        worker_.join();
+    }
+}
@@ -0,0 +1,66 @@
+#ifndef SEARCHSERVICE_H
+#define SEARCHSERVICE_H
+
+#include "util/def.h"
+#include "board/board.h"
+
+#include <QObject>
+#include <QMetaType>
+
+#include <memory>
+#include <thread>
+
+using std::shared_ptr;
+
+Q_DECLARE_METATYPE(def::TMove)
+Q_DECLARE_METATYPE(board::TSearchInfo)
+
+// 后台搜索服务：在工作线程中搜索局面副本，通过排队信号把结果送回GUI线程
+// 同一时刻只有一个搜索，新的搜索或cancel会中止并丢弃之前的搜索
+// 后台思考(ponder)：对方思考期间搜索猜测的局面，猜中则转为正常搜索，否则中止
+class SearchService : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit SearchService(QObject* parent = nullptr);
+    ~SearchService();
+
+    void start(shared_ptr<board::IBoard> snapshot);// 在工作线程中搜索snapshot
+    void ponder(shared_ptr<board::IBoard> snapshot, def::TMove predicted);// 后台思考，snapshot为走了predicted之后的局面
+    bool ponderHit(def::TMove move);// 对方走了move，猜中则转为正常搜索并返回true，否则中止后台思考
+    void cancel();// 中止当前搜索，其结果将被丢弃
+    bool isSearching() const;// 是否在正常搜索，后台思考不算
+    bool isPondering() const;
+
+signals:
+    void moveFound(def::TMove move, def::TMove ponder);// 搜索完成，在GUI线程中发出，ponder为预测的对方应着
+    void searchInfo(board::TSearchInfo info);// 每完成一层迭代，在GUI线程中发出
+
+    void infoFound(quint64 id, board::TSearchInfo info);// 工作线程内部使用
+
+    void searchFinished(quint64 id, def::TMove move, def::TMove ponder, bool ok);// 工作线程内部使用
+
+private slots:
+    void onSearchFinished(quint64 id, def::TMove move, def::TMove ponder, bool ok);
+    void onInfoFound(quint64 id, board::TSearchInfo info);
+
+private:
+    void join();
+
+private:
+    shared_ptr<board::IBoard> snapshot_;// 正在搜索的局面副本
+    std::thread worker_;
+    quint64 id_;// 每次start/cancel递增，用于识别过期的结果
+    bool searching_;
+    bool pondering_;
+    def::TMove predicted_;// 后台思考时猜测的对方走法
+
+    // 后台思考期间已经结束的搜索结果，猜中后直接发出
+    bool ponderFinished_;
+    bool ponderOk_;
+    def::TMove ponderMove_;
+    def::TMove ponderReply_;
+};
+
+#endif // SEARCHSERVICE_H
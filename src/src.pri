@@ -1,13 +1,15 @@
 HEADERS += \
     $$PWD/chess.h \
     $$PWD/palette.h \
-    $$PWD/resmgr.h
+    $$PWD/resmgr.h \
+    $$PWD/searchservice.h
 
 SOURCES += \
     $$PWD/chess.cpp \
     $$PWD/main.cpp \
     $$PWD/palette.cpp \
-    $$PWD/resmgr.cpp
+    $$PWD/resmgr.cpp \
+    $$PWD/searchservice.cpp
 	
 include(board/board.pri)
 include(util/util.pri)
@@ -58,6 +58,13 @@ TPos TPos::operator+(const TDelta& delta) const
     return {row + delta.deltaRow, col + delta.deltaCol};
 }
 
+TMove::TMove()
+    : src(INVALID_POS)
+    , dst(INVALID_POS)
+{
+
+}
+
 TMove::TMove(const TPos& s, const TPos& d)
     : src(s)
     , dst(d)
@@ -79,6 +86,11 @@ TMove& TMove::operator=(const TMove& rhs)
     return *this;
 }
 
+bool TMove::operator==(const TMove& rhs) const
+{
+    return src == rhs.src && dst == rhs.dst;
+}
+
 // 切换玩家
 void def::switchPlayer(PLAYER_E& player)
 {
@@ -39,9 +39,11 @@ namespace def
         TPos src;
         TPos dst;
 
+        TMove();// 默认为无效走法
         TMove(const TPos& s, const TPos& d);
         TMove(const TMove& other);
         TMove& operator=(const TMove& rhs);
+        bool operator==(const TMove& rhs) const;
     };
 
     const TMove INVALID_MOVE = {INVALID_POS, INVALID_POS};  // 无效走法
@@ -28,12 +28,17 @@ public:
         return data_.back();
     }
 
+    T& top()
+    {
+        return data_.back();
+    }
+
     T bottom() const
     {
         return data_.front();
     }
 
-    T at(unsigned int index) const
+    const T& at(unsigned int index) const
     {
         return data_.at(index);
     }
@@ -17,9 +17,10 @@ public:
             s[i] = i;
         }
 
+        int j = 0;
         for (int i = 0; i < 256; i ++)
         {
-            int j = (j + s[i]) & 255;
+            j = (j + s[i]) & 255;
             /*uint8_t uc = s[i];
             s[i] = s[j];
             s[j] = uc;*/
@@ -48,6 +49,13 @@ public:
         return uc0 + (uc1 << 8) + (uc2 << 16) + (uc3 << 24);
     }
 
+    uint64_t NextLongLong()  // 生成密码流的下八个字节
+    {
+        uint64_t lo = NextLong();
+        uint64_t hi = NextLong();
+        return lo + (hi << 32);
+    }
+
 private:
     uint32_t x;
     uint32_t y;
@@ -56,46 +64,44 @@ private:
 
 
 // Zobrist结构
+// 注意：每个Zobrist必须由同一个密码流依次填充，否则各个键值完全相同
 class Zobrist
 {
 public:
-    Zobrist()// 用密码流填充Zobrist
+    Zobrist()// 用零填充Zobrist
+        : qwKey(0)
+    {
+
+    }
+
+    explicit Zobrist(RC4& rc4)// 用密码流填充Zobrist
+        : qwKey(rc4.NextLongLong())
     {
-        RC4 rc4;
 
-        dwKey = rc4.NextLong();
-        dwLock0 = rc4.NextLong();
-        dwLock1 = rc4.NextLong();
     }
 
-    uint32_t getKey()
+    uint64_t getKey() const
     {
-        return dwKey;
+        return qwKey;
     }
 
     void clear()     // 用零填充Zobrist
     {
-        dwKey = dwLock0 = dwLock1 = 0;
+        qwKey = 0;
     }
 
     void Xor(const Zobrist& zobr)  // 执行XOR操作
     {
-        dwKey ^= zobr.dwKey;
-        dwLock0 ^= zobr.dwLock0;
-        dwLock1 ^= zobr.dwLock1;
+        qwKey ^= zobr.qwKey;
     }
 
     void Xor(const Zobrist& zobr1, const Zobrist& zobr2)
     {
-        dwKey ^= zobr1.dwKey ^ zobr2.dwKey;
-        dwLock0 ^= zobr1.dwLock0 ^ zobr2.dwLock0;
-        dwLock1 ^= zobr1.dwLock1 ^ zobr2.dwLock1;
+        qwKey ^= zobr1.qwKey ^ zobr2.qwKey;
     }
 
 private:
-    uint32_t dwKey;
-    uint32_t dwLock0;
-    uint32_t dwLock1;
+    uint64_t qwKey;
 };
 
 #endif // ZOBRIST_H